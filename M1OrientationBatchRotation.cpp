@@ -0,0 +1,117 @@
+#include "M1OrientationBatchRotation.h"
+
+#if defined(__AVX__)
+ #define M1_ORIENTATION_BATCH_AVX 1
+ #include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #define M1_ORIENTATION_BATCH_SSE 1
+ #include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+ #define M1_ORIENTATION_BATCH_NEON 1
+ #include <arm_neon.h>
+#endif
+
+M1OrientationBatchRotation::Matrix M1OrientationBatchRotation::makeMatrix(const Mach1::Quaternion& rotation, bool inverse) {
+    float w = rotation.w, x = rotation.x, y = rotation.y, z = rotation.z;
+    if (inverse) {
+        x = -x;
+        y = -y;
+        z = -z;
+    }
+    // Scaling by 2 / |q|^2 keeps the matrix a pure rotation for slightly denormalized input
+    float norm = w * w + x * x + y * y + z * z;
+    float s = norm > 0 ? 2.0f / norm : 0.0f;
+
+    Matrix matrix;
+    matrix.m[0][0] = 1 - s * (y * y + z * z);
+    matrix.m[0][1] = s * (x * y - w * z);
+    matrix.m[0][2] = s * (x * z + w * y);
+    matrix.m[1][0] = s * (x * y + w * z);
+    matrix.m[1][1] = 1 - s * (x * x + z * z);
+    matrix.m[1][2] = s * (y * z - w * x);
+    matrix.m[2][0] = s * (x * z - w * y);
+    matrix.m[2][1] = s * (y * z + w * x);
+    matrix.m[2][2] = 1 - s * (x * x + y * y);
+    return matrix;
+}
+
+void M1OrientationBatchRotation::rotate(const Mach1::Quaternion& rotation,
+                                        const float* x, const float* y, const float* z,
+                                        float* outX, float* outY, float* outZ,
+                                        std::size_t count, bool inverse) {
+    rotate(makeMatrix(rotation, inverse), x, y, z, outX, outY, outZ, count);
+}
+
+void M1OrientationBatchRotation::rotateScalar(const Matrix& matrix,
+                                              const float* x, const float* y, const float* z,
+                                              float* outX, float* outY, float* outZ,
+                                              std::size_t count) {
+    const float (&m)[3][3] = matrix.m;
+    for (std::size_t i = 0; i < count; i++) {
+        // Read all three components first so the output can alias the input
+        float vx = x[i], vy = y[i], vz = z[i];
+        outX[i] = m[0][0] * vx + m[0][1] * vy + m[0][2] * vz;
+        outY[i] = m[1][0] * vx + m[1][1] * vy + m[1][2] * vz;
+        outZ[i] = m[2][0] * vx + m[2][1] * vy + m[2][2] * vz;
+    }
+}
+
+void M1OrientationBatchRotation::rotate(const Matrix& matrix,
+                                        const float* x, const float* y, const float* z,
+                                        float* outX, float* outY, float* outZ,
+                                        std::size_t count) {
+    const float (&m)[3][3] = matrix.m;
+    std::size_t i = 0;
+
+#if M1_ORIENTATION_BATCH_AVX
+    const __m256 m00 = _mm256_set1_ps(m[0][0]), m01 = _mm256_set1_ps(m[0][1]), m02 = _mm256_set1_ps(m[0][2]);
+    const __m256 m10 = _mm256_set1_ps(m[1][0]), m11 = _mm256_set1_ps(m[1][1]), m12 = _mm256_set1_ps(m[1][2]);
+    const __m256 m20 = _mm256_set1_ps(m[2][0]), m21 = _mm256_set1_ps(m[2][1]), m22 = _mm256_set1_ps(m[2][2]);
+    for (; i + 8 <= count; i += 8) {
+        __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+        _mm256_storeu_ps(outX + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, vx), _mm256_mul_ps(m01, vy)), _mm256_mul_ps(m02, vz)));
+        _mm256_storeu_ps(outY + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m10, vx), _mm256_mul_ps(m11, vy)), _mm256_mul_ps(m12, vz)));
+        _mm256_storeu_ps(outZ + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m20, vx), _mm256_mul_ps(m21, vy)), _mm256_mul_ps(m22, vz)));
+    }
+#elif M1_ORIENTATION_BATCH_SSE
+    const __m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]), m02 = _mm_set1_ps(m[0][2]);
+    const __m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]), m12 = _mm_set1_ps(m[1][2]);
+    const __m128 m20 = _mm_set1_ps(m[2][0]), m21 = _mm_set1_ps(m[2][1]), m22 = _mm_set1_ps(m[2][2]);
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+        _mm_storeu_ps(outX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, vx), _mm_mul_ps(m01, vy)), _mm_mul_ps(m02, vz)));
+        _mm_storeu_ps(outY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, vx), _mm_mul_ps(m11, vy)), _mm_mul_ps(m12, vz)));
+        _mm_storeu_ps(outZ + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, vx), _mm_mul_ps(m21, vy)), _mm_mul_ps(m22, vz)));
+    }
+#elif M1_ORIENTATION_BATCH_NEON
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t vx = vld1q_f32(x + i), vy = vld1q_f32(y + i), vz = vld1q_f32(z + i);
+        float32x4_t rx = vmulq_n_f32(vx, m[0][0]);
+        rx = vmlaq_n_f32(rx, vy, m[0][1]);
+        rx = vmlaq_n_f32(rx, vz, m[0][2]);
+        float32x4_t ry = vmulq_n_f32(vx, m[1][0]);
+        ry = vmlaq_n_f32(ry, vy, m[1][1]);
+        ry = vmlaq_n_f32(ry, vz, m[1][2]);
+        float32x4_t rz = vmulq_n_f32(vx, m[2][0]);
+        rz = vmlaq_n_f32(rz, vy, m[2][1]);
+        rz = vmlaq_n_f32(rz, vz, m[2][2]);
+        vst1q_f32(outX + i, rx);
+        vst1q_f32(outY + i, ry);
+        vst1q_f32(outZ + i, rz);
+    }
+#endif
+
+    rotateScalar(matrix, x + i, y + i, z + i, outX + i, outY + i, outZ + i, count - i);
+}
+
+const char* M1OrientationBatchRotation::getInstructionSet() {
+#if M1_ORIENTATION_BATCH_AVX
+    return "avx";
+#elif M1_ORIENTATION_BATCH_SSE
+    return "sse";
+#elif M1_ORIENTATION_BATCH_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
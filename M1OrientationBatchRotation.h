@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+#include "m1_mathematics/Orientation.h"
+
+// Rotates a block of direction vectors (sources, speakers) by one orientation, for renderers that
+// would otherwise rotate each vector in scalar code every block. Vectors are passed as structure of
+// arrays (separate x, y and z arrays) and rotated as v' = q v q^-1 in the quaternion's own axes.
+//
+// The quaternion is turned into a 3x3 matrix once per call and the vectors are then processed with
+// AVX, SSE or NEON, whichever the module is compiled with, falling back to scalar code for the tail
+// and on other targets. No allocation or locking, safe on the audio thread. Output arrays may alias
+// the input arrays (in-place rotation).
+class M1OrientationBatchRotation
+{
+public:
+    struct Matrix {
+        float m[3][3];
+    };
+
+    // `inverse` rotates by the conjugate, e.g. world-space sources into head-relative directions
+    static Matrix makeMatrix(const Mach1::Quaternion& rotation, bool inverse = false);
+
+    static void rotate(const Mach1::Quaternion& rotation,
+                       const float* x, const float* y, const float* z,
+                       float* outX, float* outY, float* outZ,
+                       std::size_t count, bool inverse = false);
+    static void rotate(const Matrix& matrix,
+                       const float* x, const float* y, const float* z,
+                       float* outX, float* outY, float* outZ,
+                       std::size_t count);
+
+    // Reference implementation, used for the remainder after the vector loop
+    static void rotateScalar(const Matrix& matrix,
+                             const float* x, const float* y, const float* z,
+                             float* outX, float* outY, float* outZ,
+                             std::size_t count);
+
+    // "avx", "sse", "neon" or "scalar"
+    static const char* getInstructionSet();
+};
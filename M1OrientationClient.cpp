@@ -3,6 +3,8 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <charconv>
 
 #include "libs/json/single_include/nlohmann/json.hpp"
 
@@ -12,255 +14,919 @@ void M1OrientationClient::oscMessageReceived(const juce::OSCMessage& message) {
             int newHelperPort = message[0].getInt32();
             DBG("[M1OrientationClient] Helper port changed to: " + std::to_string(newHelperPort));
             
-            // Update our stored helper port
+            // Update our stored helper port, the polling thread reconnects to it
             helperPort = newHelperPort;
-            
-            // Reconnect with the new port
-            helperInterface.disconnect();
-            helperInterface.connect("127.0.0.1", helperPort);
         }
     }
 }
 
 void M1OrientationClient::send(std::string path, std::string data)
 {
+    M1_ORIENTATION_RT_SYSCALL(); // blocking HTTP request
     httplib::Client client("localhost", serverPort);
     time_t usec = 10000; // 10ms
     client.set_connection_timeout(0, usec);
     client.set_read_timeout(0, usec);
     client.set_write_timeout(0, usec);
-    client.Post(path, data, "text/plain");
+
+    M1_ORIENTATION_TRACE_SPAN("command");
+    int64_t startMicros = M1OrientationStats::nowMicros();
+    auto res = client.Post(path, data, "text/plain");
+    stats.commandLatency.record(M1OrientationStats::nowMicros() - startMicros);
+    if (res && res->status == 200) {
+        stats.commandsSucceeded++;
+    } else if (res.error() == httplib::Error::Read || res.error() == httplib::Error::Write) {
+        stats.commandTimeouts++;
+    } else {
+        stats.commandsFailed++;
+    }
 }
     
 void M1OrientationClient::command_setTrackingYawEnabled(bool enable) {
+    M1_ORIENTATION_RT_API("command_setTrackingYawEnabled");
     send("/setTrackingYawEnabled", nlohmann::json({ enable }).dump());
 }
 
 void M1OrientationClient::command_setTrackingPitchEnabled(bool enable) {
+    M1_ORIENTATION_RT_API("command_setTrackingPitchEnabled");
     send("/setTrackingPitchEnabled", nlohmann::json({ enable }).dump());
 }
 
 void M1OrientationClient::command_setTrackingRollEnabled(bool enable) {
+    M1_ORIENTATION_RT_API("command_setTrackingRollEnabled");
     send("/setTrackingRollEnabled", nlohmann::json({ enable }).dump());
 }
 
 void M1OrientationClient::command_setTrackingYawInverted(bool invert) {
+    M1_ORIENTATION_RT_API("command_setTrackingYawInverted");
     send("/setTrackingYawInverted", nlohmann::json({ invert }).dump());
 }
 
 void M1OrientationClient::command_setTrackingPitchInverted(bool invert) {
+    M1_ORIENTATION_RT_API("command_setTrackingPitchInverted");
     send("/setTrackingPitchInverted", nlohmann::json({ invert }).dump());
 }
 
 void M1OrientationClient::command_setTrackingRollInverted(bool invert) {
+    M1_ORIENTATION_RT_API("command_setTrackingRollInverted");
     send("/setTrackingRollInverted", nlohmann::json({ invert }).dump());
 }
 
 void M1OrientationClient::command_setAdditionalDeviceSettings(std::string additional_settings) {
+    M1_ORIENTATION_RT_API("command_setAdditionalDeviceSettings");
     send("/setDeviceSettings", nlohmann::json({ additional_settings }).dump());
 }
 
 void M1OrientationClient::command_recenter() {
+    M1_ORIENTATION_RT_API("command_recenter");
     send("/recenter", "");
 }
 
 Mach1::Orientation M1OrientationClient::getOrientation() {
-    return m_orientation;
+    M1_ORIENTATION_RT_API("getOrientation");
+    stats.recordSampleRead();
+    return m_orientation.read();
+}
+
+void M1OrientationClient::rotateDirections(const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, std::size_t count, bool inverse) {
+    M1_ORIENTATION_RT_API("rotateDirections");
+    M1OrientationBatchRotation::rotate(getOrientation().GetGlobalRotationAsQuaternion(), x, y, z, outX, outY, outZ, count, inverse);
+}
+
+Mach1::Orientation M1OrientationClient::getRawOrientation() {
+    M1_ORIENTATION_RT_API("getRawOrientation");
+    return rawOrientation.read();
+}
+
+void M1OrientationClient::resetReceivedSamples() {
+    // Polling thread only. The next /ping asks for everything the server holds, and the new server's
+    // samples are neither mapped with the old clock offset nor blended with the old server's
+    receivedSequence = 0;
+    clockSync.reset();
+    history.clear();
+    transformResetRequested = true;
+}
+
+void M1OrientationClient::publishOrientations(M1OrientationHistorySample* samples, std::size_t count) {
+    // Polling thread only. `samples` are raw on entry and transformed in place, the newest one is
+    // published to the snapshots and all of them are appended to the history.
+    if (count == 0) {
+        return;
+    }
+    Mach1::Orientation orientation;
+    orientation.SetRotation(samples[count - 1].rotation);
+    rawOrientation.publish(orientation);
+    {
+        std::lock_guard<M1OrientationMutex> lock(transformMutex);
+        if (transform) {
+            if (transformResetRequested.exchange(false)) {
+                transform->reset();
+            }
+            bool recenter = transformRecenterRequested.exchange(false);
+            for (std::size_t i = 0; i < count; i++) {
+                Mach1::Quaternion raw = samples[i].rotation;
+                samples[i].rotation = transform->process(raw, samples[i].timestampMicros);
+                if (recenter && i + 1 == count) {
+                    // Recenter on the newest sample so it is already published centered, without smoothing into it
+                    transform->recenter();
+                    transform->reset();
+                    samples[i].rotation = transform->process(raw, samples[i].timestampMicros);
+                }
+            }
+            orientation.SetRotation(samples[count - 1].rotation);
+        }
+    }
+    history.append(samples, count);
+    m_orientation.publish(orientation);
+}
+
+const M1OrientationConventionAdapter& M1OrientationClient::getConventionAdapter(const M1OrientationDeviceInfo& device) {
+    // Polling thread only. Adapters are resolved from the rules once per device and cached by handle,
+    // rules can match on the type so a device reporting another type is resolved again.
+    if (conventionRulesChanged.exchange(false)) {
+        std::lock_guard<M1OrientationMutex> lock(conventionMutex);
+        activeConventionRules = conventionRules;
+        conventionAdapters.clear();
+    }
+    CachedConventionAdapter& cached = conventionAdapters[device.getDeviceHandle()];
+    if (cached.resolved && cached.type == device.getDeviceType()) {
+        return cached.adapter;
+    }
+    M1OrientationInputConvention input;
+    for (auto& rule : activeConventionRules) {
+        if (rule.matches(device)) {
+            input = rule.input;
+            break;
+        }
+    }
+    cached.resolved = true;
+    cached.type = device.getDeviceType();
+    cached.adapter = M1OrientationConventionAdapter(input);
+    return cached.adapter;
+}
+
+bool M1OrientationClient::ingestSample(const M1OrientationDeviceInfo& device, const M1OrientationRawSample& sample, Mach1::Orientation& orientation) {
+    return ingestSample(getConventionAdapter(device), sample.values, sample.count, orientation);
+}
+
+bool M1OrientationClient::ingestSample(const M1OrientationConventionAdapter& adapter, const float* values, int count, Mach1::Orientation& orientation) {
+    M1OrientationSampleStatus status = adapter.toOrientation(values, count, orientation);
+    if (status == M1OrientationSampleRenormalized) {
+        stats.samplesRenormalized++;
+    } else if (!M1OrientationIsSampleAccepted(status)) {
+        stats.samplesRejected++;
+    }
+    return M1OrientationIsSampleAccepted(status);
+}
+
+void M1OrientationClient::setInputConventions(std::vector<M1OrientationConventionRule> rules) {
+    M1_ORIENTATION_RT_API("setInputConventions");
+    {
+        std::lock_guard<M1OrientationMutex> lock(conventionMutex);
+        conventionRules = std::move(rules);
+    }
+    conventionRulesChanged = true;
+}
+
+std::size_t M1OrientationClient::getOrientationHistory(M1OrientationHistorySample* samples, std::size_t maxCount) {
+    M1_ORIENTATION_RT_API("getOrientationHistory");
+    return history.readLatest(samples, maxCount);
+}
+
+bool M1OrientationClient::getOrientationAt(juce::int64 timestampMicros, Mach1::Orientation& orientation) {
+    M1_ORIENTATION_RT_API("getOrientationAt");
+    Mach1::Quaternion rotation;
+    if (!history.sampleAt(timestampMicros, rotation)) {
+        return false;
+    }
+    orientation.SetRotation(rotation);
+    return true;
+}
+
+void M1OrientationClient::setTransform(std::unique_ptr<M1OrientationTransform> newTransform) {
+    M1_ORIENTATION_RT_API("setTransform");
+    std::lock_guard<M1OrientationMutex> lock(transformMutex);
+    transform = std::move(newTransform);
+    transformRecenterRequested = false;
+    transformResetRequested = false;
+}
+
+void M1OrientationClient::recenterTransform() {
+    M1_ORIENTATION_RT_API("recenterTransform");
+    transformRecenterRequested = true;
 }
 
 bool M1OrientationClient::getTrackingYawEnabled() {
+    M1_ORIENTATION_RT_API("getTrackingYawEnabled");
     return bTrackingYawEnabled;
 }
 
 bool M1OrientationClient::getTrackingPitchEnabled() {
+    M1_ORIENTATION_RT_API("getTrackingPitchEnabled");
     return bTrackingPitchEnabled;
 }
 
 bool M1OrientationClient::getTrackingRollEnabled() {
+    M1_ORIENTATION_RT_API("getTrackingRollEnabled");
     return bTrackingRollEnabled;
 }
 
 bool M1OrientationClient::getTrackingYawInverted() {
+    M1_ORIENTATION_RT_API("getTrackingYawInverted");
     return bTrackingYawInverted;
 }
 
 bool M1OrientationClient::getTrackingPitchInverted() {
+    M1_ORIENTATION_RT_API("getTrackingPitchInverted");
     return bTrackingPitchInverted;
 }
 
 bool M1OrientationClient::getTrackingRollInverted() {
+    M1_ORIENTATION_RT_API("getTrackingRollInverted");
     return bTrackingRollInverted;
 }
 
 int M1OrientationClient::getServerPort() {
+    M1_ORIENTATION_RT_API("getServerPort");
     return serverPort;
 }
 
 int M1OrientationClient::getHelperPort() {
+    M1_ORIENTATION_RT_API("getHelperPort");
     return helperPort;
 }
 
 void M1OrientationClient::setClientType(std::string client_type = "") {
+    M1_ORIENTATION_RT_API("setClientType");
     // sets the client type for unique client behaviors
     // Warning: Must be set before the init() call
     clientType = client_type;
 }
 
+void M1OrientationClient::setSettingsFilePath(std::string jsonSettingsFilePath) {
+    M1_ORIENTATION_RT_API("setSettingsFilePath");
+    settingsFilePath = jsonSettingsFilePath;
+}
+
 std::string M1OrientationClient::getClientType() {
+    M1_ORIENTATION_RT_API("getClientType");
     return clientType;
 }
 
 void M1OrientationClient::setStatusCallback(std::function<void(bool success, std::string message, std::string connectedDeviceName, int connectedDeviceType, std::string connectedDeviceAddress)> callback)
 {
+    M1_ORIENTATION_RT_API("setStatusCallback");
     this->statusCallback = callback;
 }
 
 bool M1OrientationClient::init(int serverPort, int helperPort) {
-    // TODO: Add UI feedback for this process to stop user from selecting another device during connection
-    
-    // Using `currentApplicationFile` to be safe for both plugins and apps on all OS targets
-    //juce::File pluginExe = juce::File::getSpecialLocation(juce::File::currentApplicationFile);
-    //juce::File appDirectory = pluginExe.getParentDirectory();
-    
-    // Using common support files installation location
-    juce::File m1SupportDirectory = juce::File::getSpecialLocation(juce::File::commonApplicationDataDirectory);
-    
-    juce::File settingsFile;
-    if ((juce::SystemStats::getOperatingSystemType() & juce::SystemStats::MacOSX) != 0) {
-        // test for any mac OS
-        settingsFile = m1SupportDirectory.getChildFile("Application Support").getChildFile("Mach1");
-    } else if ((juce::SystemStats::getOperatingSystemType() & juce::SystemStats::Windows) != 0) {
-        // test for any windows OS
-        settingsFile = m1SupportDirectory.getChildFile("Mach1");
-    } else {
-        settingsFile = m1SupportDirectory.getChildFile("Mach1");
-    }
-    settingsFile = settingsFile.getChildFile("settings.json");
-    
-    DBG("Opening settings file: " + settingsFile.getFullPathName().quoted());
-    if (settingsFile.exists()) {
-        // Found the settings.json
-        juce::var mainVar = juce::JSON::parse(juce::File(settingsFile));
-        this->serverPort = mainVar["serverPort"];
-        this->helperPort = mainVar["helperPort"];
-    } else {
-        if (!settingsFile.exists()) {
-            // Hiding UI error by default
-            // TODO: handle this more elegantly
-//            juce::AlertWindow::showMessageBoxAsync(
-//                juce::AlertWindow::NoIcon,
-//                "Warning",
-//                "Mach1: settings.json file doesn't exist in Mach1's Application Support directory, please reinstall the Spatial System",
-//                "",
-//                nullptr,
-//                juce::ModalCallbackFunction::create(([&](int result) {
-//                   //juce::JUCEApplicationBase::quit();
-//                }))
-//            );
-            return false;
-        }
+    M1_ORIENTATION_RT_API("init");
+    M1_ORIENTATION_RT_SYSCALL(); // starts threads and sockets
+    if (pollThread.joinable()) {
+        close(); // initialized again, the previous polling thread has to exit first
     }
+    // TODO: Add UI feedback for this process to stop user from selecting another device during connection
+    initStartedMillis = juce::Time::getMillisecondCounterHiRes();
+    initDurationMillis = 0;
+    firstServerResponseMillis = 0;
+    firstSampleMillis = 0;
+    hasFirstSample = false;
     
-    // This is for a service handling the orientation manager if the helper port is discovered
-    if (this->helperPort != 0) {
-        helperInterface.connect("127.0.0.1", this->helperPort);
+    // The settings file is parsed once per process and then watched, so port edits apply without reloading clients
+    std::string settingsFilePath = this->settingsFilePath.empty() ? getDefaultSettingsFilePath() : this->settingsFilePath;
+    M1OrientationSettingsData settings;
+    if (!loadSettings(settingsFilePath, settings)) {
+        // Hiding UI error by default
+        // TODO: handle this more elegantly
+        return false;
     }
+    this->serverPort = settings.serverPort;
+    this->helperPort = settings.helperPort;
     
     isRunning = true;
 
-    std::thread([&, this]() {
-        httplib::Client client("localhost", this->serverPort);
-        time_t usec = 10000; // 10ms
-        client.set_connection_timeout(0, usec);
-        client.set_read_timeout(0, usec);
-        client.set_write_timeout(0, usec);
+    // Started here on the caller's thread so close() can't race it, clients of the same file share one
+    // watching thread and only the first one to start pays for creating it
+    settingsWatcher.start(settingsFilePath, [this](M1OrientationSettingsData settings) {
+        // The polling thread picks these up and swaps its transport, the orientation state is kept
+        this->serverPort = settings.serverPort;
+        this->helperPort = settings.helperPort;
+    });
 
-        int failedRequestCount = 0;
-        static const int MAX_FAILED_REQUESTS = 3; // Adjust this value as needed
+    // Everything past this point (sockets, the first /ping) happens lazily on the polling thread
+    // so hosts scanning or instantiating plugins are never blocked by the client
+    pollThread = std::thread([this]() {
 
-        while (isRunning) {
-            auto res = client.Get("/ping");
-            if (res && res->body != "") {
-                failedRequestCount = 0;  // Reset counter on successful request
-                setConnectedToServer(true);
-                std::string body = res->body;
-                if (body != "") {
-                    auto j = nlohmann::json::parse(body);
+        std::unique_ptr<httplib::Client> client;
+        int clientServerPort = 0;
+        int clientHelperPort = 0;
 
-                    std::vector<M1OrientationDeviceInfo> devices;
-                    for (int i = 0; i < j["devices"].size(); i++) {
-                        auto m = j["devices"][i];
+        int helperRequestIntervalMs = HELPER_REQUEST_MIN_INTERVAL_MS;
+        juce::uint32 lastHelperRequestMillis = 0;
+        juce::uint32 lastClientExistsMillis = 0;
+        std::string pingPath; // reused, servers that batch reply with every sample after `since`
 
-                        std::string deviceName = m.at(0);
-                        enum M1OrientationDeviceType deviceType = (enum M1OrientationDeviceType)m.at(1);
-                        std::string deviceAddress = m.at(2);
-                        bool hasStrength = m.at(3);
-                        int deviceStrength = m.at(4);
+        while (isRunning) {
+            recycleDeviceStreams();
 
-                        devices.push_back(M1OrientationDeviceInfo(deviceName, deviceType, deviceAddress, hasStrength ? deviceStrength : false));
-                    }
+            // While a trace is replaying it stands in for the server
+            int replaySleepMillis = stepReplay();
+            if (replaySleepMillis >= 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(replaySleepMillis));
+                continue;
+            }
 
-                    mutex.lock();
-                    this->devices = devices;
-                    int currentDeviceIdx = j["currentDeviceIdx"];
-                    if (currentDeviceIdx >= 0) {
-                        currentDevice = devices[currentDeviceIdx];
-                    }
-                    else {
-                        currentDevice = M1OrientationDeviceInfo();
+            // (Re)create the transport when the ports are first known or changed in settings.json
+            if (!client || clientServerPort != this->serverPort) {
+                clientServerPort = this->serverPort;
+                client = std::make_unique<httplib::Client>("localhost", clientServerPort);
+                time_t usec = 10000; // 10ms
+                client->set_connection_timeout(0, usec);
+                client->set_read_timeout(0, usec);
+                client->set_write_timeout(0, usec);
+                // Keeping the connection open means a restarted server shows up as a refused connection on the next poll
+                client->set_keep_alive(true);
+            }
+            if (clientHelperPort != this->helperPort) {
+                clientHelperPort = this->helperPort;
+                connectHelperInterface(clientHelperPort);
+            }
+
+            int64_t pingStartMicros = M1OrientationStats::nowMicros();
+            auto res = [&]() {
+                M1_ORIENTATION_TRACE_SPAN("receive");
+                char since[16];
+                auto end = std::to_chars(since, since + sizeof(since), receivedSequence).ptr;
+                pingPath.assign("/ping?since=").append(since, end);
+                return client->Get(pingPath);
+            }();
+            if (res && res->body != "") {
+                stats.pingRoundTrip.record(M1OrientationStats::nowMicros() - pingStartMicros);
+                stats.pingsSucceeded++;
+                failedRequestCount = 0;  // Reset counter on successful request
+                if (!isConnectedToServer()) {
+                    helperRequestIntervalMs = HELPER_REQUEST_MIN_INTERVAL_MS;
+                    resetReceivedSamples(); // possibly a different server process
+                    if (hasSessionState) {
+                        beginSessionRestore();
                     }
-                    mutex.unlock();
-
-					if (j["orientation"].size() == 3) {
-                        auto raw_rot = j["orientation"];
-                        Mach1::Float3 incomingRot = {raw_rot[0], raw_rot[1], raw_rot[2]};
-						m_orientation.SetRotation(incomingRot.Map(-1, 1, -PI, PI));
-					}
-					else if (j["orientation"].size() == 4) {
-						// quat input
-                        auto raw_quat = j["orientation"];
-						m_orientation.SetRotation({ raw_quat[0], raw_quat[1], raw_quat[2], raw_quat[3] });
-					}
-
-                    bTrackingYawEnabled = j["trackingEnabled"][0];
-                    bTrackingPitchEnabled = j["trackingEnabled"][1];
-                    bTrackingRollEnabled = j["trackingEnabled"][2];
-                    bTrackingYawInverted = j["trackingInverted"][0];
-                    bTrackingPitchInverted = j["trackingInverted"][1];
-                    bTrackingRollInverted = j["trackingInverted"][2];
                 }
+                setConnectedToServer(true);
+                if (firstServerResponseMillis == 0) {
+                    firstServerResponseMillis = juce::Time::getMillisecondCounterHiRes() - initStartedMillis;
+                }
+                handlePingResponse(res->body);
             }
             else {
+                stats.pingsFailed++;
                 failedRequestCount++;
-                if (failedRequestCount >= MAX_FAILED_REQUESTS) {
+                // A refused connection means the server is gone, no need to wait for more timeouts
+                if (res.error() == httplib::Error::Connection || failedRequestCount >= MAX_FAILED_REQUESTS) {
                     setConnectedToServer(false);
                 }
             }
             
-            if (this->helperPort != 0) {
-                if (!isConnectedToServer()) {
+            if (clientHelperPort != 0) {
+                juce::uint32 now = juce::Time::getMillisecondCounter();
+                if (!isConnectedToServer() && now - lastHelperRequestMillis >= (juce::uint32)helperRequestIntervalMs) {
+                    // Backing off so a missing server doesn't get the helper hammered every poll
                     juce::OSCMessage clientRequestsServerMessage = juce::OSCMessage(juce::OSCAddressPattern("/m1-clientRequestsServer"));
                     helperInterface.send(clientRequestsServerMessage);
+                    lastHelperRequestMillis = now;
+                    helperRequestIntervalMs = std::min(helperRequestIntervalMs * 2, HELPER_REQUEST_MAX_INTERVAL_MS);
                 }
 
-                juce::OSCMessage clientExistsMessage = juce::OSCMessage(juce::OSCAddressPattern("/m1-clientExists"));
-                helperInterface.send(clientExistsMessage);
+                if (now - lastClientExistsMillis >= (juce::uint32)POLL_INTERVAL_MS) {
+                    juce::OSCMessage clientExistsMessage = juce::OSCMessage(juce::OSCAddressPattern("/m1-clientExists"));
+                    helperInterface.send(clientExistsMessage);
+                    lastClientExistsMillis = now;
+                }
+            }
+
+            stats.updateRate();
+            dumpStatsIfNeeded();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(isConnectedToServer() ? POLL_INTERVAL_MS : RECONNECT_POLL_INTERVAL_MS));
+        }
+    });
+
+    initDurationMillis = juce::Time::getMillisecondCounterHiRes() - initStartedMillis;
+    DBG("[M1OrientationClient] init() took " + std::to_string(initDurationMillis.load()) + "ms");
+    return true;
+}
+
+void M1OrientationClient::connectHelperInterface(int port) {
+    // This is for a service handling the orientation manager if the helper port is discovered
+    helperInterface.disconnect();
+    if (port != 0) {
+        helperInterface.connect("127.0.0.1", port);
+    }
+}
+
+void M1OrientationClient::handlePingResponse(const std::string& body) {
+    int64_t parseStartMicros = M1OrientationStats::nowMicros();
+    // Reused across polls so parsing doesn't reallocate the device and orientation vectors
+    M1OrientationPingResponse& response = pingResponse;
+    {
+        M1_ORIENTATION_TRACE_SPAN("parse");
+        if (!response.parse(body)) {
+            DBG("[M1OrientationClient] Ignoring malformed /ping response");
+            return;
+        }
+    }
+    stats.parseDuration.record(M1OrientationStats::nowMicros() - parseStartMicros);
+    M1_ORIENTATION_TRACE_SPAN("publish");
+
+    std::vector<M1OrientationDeviceInfo>& devices = response.devices;
+    M1OrientationDeviceInfo serverCurrentDevice = response.getCurrentDevice();
+    bool serverTrackingFlags[6] = {
+        response.trackingEnabled[0], response.trackingEnabled[1], response.trackingEnabled[2],
+        response.trackingInverted[0], response.trackingInverted[1], response.trackingInverted[2],
+    };
+
+    // While restoring, the cached device list, selection and flags stay visible until the server catches up
+    bool restoring = sessionRestorePending && !restoreSession(devices, serverCurrentDevice, serverTrackingFlags);
+
+    bool stateChanged = false;
+    deviceEvents.clear();
+    if (!restoring || !devices.empty()) {
+        responseDeviceIndex.rebuild(devices); // outside the lock, swapped in with the list
+    }
+    std::vector<std::function<void(const std::vector<M1OrientationDeviceEvent>& events)>> listeners;
+    mutex.lock();
+    if (!restoring || !devices.empty()) {
+        M1OrientationDiffDeviceLists(this->devices, deviceIndex, devices, responseDeviceIndex, deviceEvents);
+        // Unchanged lists are not copied. Devices are compared in order and with their full state, so
+        // reorders and signal, battery or status changes all reach getDevices().
+        bool devicesChanged = !std::equal(this->devices.begin(), this->devices.end(), devices.begin(), devices.end(), [](const M1OrientationDeviceInfo& a, const M1OrientationDeviceInfo& b) {
+            return a == b && a.hasSameState(b);
+        });
+        if (devicesChanged) {
+            stateChanged = true;
+            this->devices = devices;
+            deviceIndex.swap(responseDeviceIndex);
+            pruneConventionAdapters();
+        }
+        if (!deviceEvents.empty()) {
+            for (auto& listener : deviceListListeners) {
+                listeners.push_back(listener.second);
             }
+        }
+    }
+    if (!restoring && currentDevice != serverCurrentDevice) {
+        currentDevice = serverCurrentDevice;
+        currentDeviceType.store(currentDevice.getDeviceType(), std::memory_order_release);
+        transformResetRequested = true; // smoothing shouldn't blend across devices
+        stateChanged = true;
+    }
+    mutex.unlock();
+
+    // Outside the lock so listeners can call back into the client
+    for (auto& listener : listeners) {
+        listener(deviceEvents);
+    }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    // Validated and converted once here from the device's convention, everything downstream sees
+    // finite unit rotations in client axes. Rejected samples leave the last good orientation published.
+    // Timestamps are taken to the client's clock here too, so the history, the trace and the device
+    // streams all hold M1OrientationStats::nowMicros() capture times whatever the server reports.
+    int64_t receivedMicros = M1OrientationStats::nowMicros();
+    historyBatch.clear();
+    Mach1::Orientation orientation;
+    // A sequence behind the acknowledged one means the server restarted and is counting from scratch.
+    // Its batch may well be empty, it only sends samples after `since`, so the top level sequence counts too.
+    bool restarted = (response.sequence != 0 && (juce::int32)(response.sequence - receivedSequence) < 0)
+        || (!response.samples.empty() && (juce::int32)(response.samples.back().sequence - receivedSequence) < 0);
+    if (restarted) {
+        resetReceivedSamples();
+    }
+    // A restarted server's batch was filtered by the old `since`, this frame falls back to its current orientation
+    if (response.hasSamples && !(restarted && response.samples.empty())) {
+        // Batching servers send every sample since the sequence acknowledged in the request
+        if (!response.samples.empty()) {
+            // The newest sample is the one closest to its arrival, the whole batch maps with its offset
+            clockSync.observe(response.samples.back().timestampMicros, receivedMicros);
+        }
+        for (auto& sample : response.samples) {
+            if (receivedSequence != 0 && (juce::int32)(sample.sequence - receivedSequence) <= 0) {
+                continue; // already received in an earlier frame
+            }
+            if (ingestSample(serverCurrentDevice, sample.orientation, orientation)) {
+                historyBatch.push_back({ sample.sequence, clockSync.toClientMicros(sample.timestampMicros, receivedMicros), orientation.GetGlobalRotationAsQuaternion() });
+            }
         }
+        if (!response.samples.empty()) {
+            receivedSequence = response.samples.back().sequence;
+        }
+    }
+    else if (response.hasOrientation && (response.sequence == 0 || response.sequence != receivedSequence)) {
+        if (ingestSample(serverCurrentDevice, response.orientation, orientation)) {
+            juce::uint32 sequence = response.sequence != 0 ? response.sequence : receivedSequence + 1;
+            juce::int64 timestampMicros = receivedMicros;
+            if (response.hasTimestamp) {
+                clockSync.observe(response.timestampMicros, receivedMicros);
+                timestampMicros = clockSync.toClientMicros(response.timestampMicros, receivedMicros);
+            }
+            historyBatch.push_back({ sequence, timestampMicros, orientation.GetGlobalRotationAsQuaternion() });
+            receivedSequence = sequence;
+        }
+    }
+    bool receivedOrientation = !historyBatch.empty();
+    if (receivedOrientation) {
+        orientation.SetRotation(historyBatch.back().rotation);
+        for (std::size_t i = 0; i < historyBatch.size(); i++) {
+            stats.recordSampleReceived(receivedMicros);
+        }
+        if (recording) {
+            juce::uint32 flags = M1OrientationTraceRecord::MainOrientation;
+            const juce::uint32 trackingFlagBits[6] = {
+                M1OrientationTraceRecord::TrackingYawEnabled, M1OrientationTraceRecord::TrackingPitchEnabled, M1OrientationTraceRecord::TrackingRollEnabled,
+                M1OrientationTraceRecord::TrackingYawInverted, M1OrientationTraceRecord::TrackingPitchInverted, M1OrientationTraceRecord::TrackingRollInverted,
+            };
+            for (int i = 0; i < 6; i++) {
+                flags |= serverTrackingFlags[i] ? trackingFlagBits[i] : 0;
+            }
+            M1OrientationDeviceHandle handle = serverCurrentDevice.getDeviceType() != M1OrientationManagerDeviceTypeNone ? serverCurrentDevice.getDeviceHandle() : M1OrientationDeviceHandleNone;
+            for (auto& sample : historyBatch) {
+                Mach1::Orientation sampleOrientation;
+                sampleOrientation.SetRotation(sample.rotation);
+                recordTraceSample(flags, handle, sampleOrientation, sample.sequence, sample.timestampMicros); // as stored in the history
+            }
+        }
+        // The whole frame goes through the transform and into the history in one pass
+        publishOrientations(historyBatch.data(), historyBatch.size());
+    }
+
+    // Subscribed device streams are all published from this one parse
+    bool publishedDeviceStream = false;
+    if (response.hasDeviceOrientations) {
+        for (auto& entry : response.deviceOrientations) {
+            const M1OrientationDeviceInfo& device = devices[entry.deviceIdx];
+            Mach1::Orientation deviceOrientation;
+            if (!ingestSample(device, entry.orientation, deviceOrientation)) {
+                continue;
+            }
+            juce::int64 timestampMicros = receivedMicros;
+            if (entry.hasTimestamp) {
+                clockSync.observe(entry.timestampMicros, receivedMicros);
+                timestampMicros = clockSync.toClientMicros(entry.timestampMicros, receivedMicros);
+            }
+            publishedDeviceStream |= publishDeviceStream(device.getDeviceHandle(), deviceOrientation, timestampMicros);
+        }
+    }
+    else if (receivedOrientation && serverCurrentDevice.getDeviceType() != M1OrientationManagerDeviceTypeNone) {
+        // Servers without multi-device support still feed the stream of the device they track
+        publishedDeviceStream = publishDeviceStream(serverCurrentDevice.getDeviceHandle(), orientation, historyBatch.back().timestampMicros);
+    }
+    if (publishedDeviceStream) {
+        deviceStreamsFrame++;
+    }
+
+    if (!hasFirstSample && receivedOrientation) {
+        signalFirstSample();
+    }
+
+    if (!restoring) {
+        stateChanged |= setTrackingFlags(serverTrackingFlags);
+    }
+    if (stateChanged) {
+        stateGeneration++;
+    }
+    hasSessionState = true;
+}
 
-    }).detach();
+void M1OrientationClient::signalFirstSample() {
+    firstSampleMillis = juce::Time::getMillisecondCounterHiRes() - initStartedMillis;
+    DBG("[M1OrientationClient] First orientation sample after " + std::to_string(firstSampleMillis.load()) + "ms");
+
+    std::function<void()> callback;
+    {
+        std::lock_guard<M1OrientationMutex> lock(firstSampleMutex);
+        hasFirstSample = true;
+        callback = firstSampleCallback;
+    }
+    firstSampleCondition.notify_all();
+    if (callback) {
+        callback();
+    }
+}
+
+bool M1OrientationClient::hasReceivedFirstSample() {
+    M1_ORIENTATION_RT_API("hasReceivedFirstSample");
+    return hasFirstSample;
+}
+
+bool M1OrientationClient::waitForFirstSample(int timeoutMillis) {
+    M1_ORIENTATION_RT_API("waitForFirstSample");
+    M1_ORIENTATION_RT_SYSCALL();
+    std::unique_lock<M1OrientationMutex> lock(firstSampleMutex);
+    return firstSampleCondition.wait_for(lock, std::chrono::milliseconds(timeoutMillis), [this]() {
+        return hasFirstSample || !isRunning;
+    }) && hasFirstSample;
+}
+
+void M1OrientationClient::setFirstSampleCallback(std::function<void()> callback) {
+    M1_ORIENTATION_RT_API("setFirstSampleCallback");
+    bool alreadyReceived;
+    {
+        std::lock_guard<M1OrientationMutex> lock(firstSampleMutex);
+        firstSampleCallback = callback;
+        alreadyReceived = hasFirstSample;
+    }
+    // Late subscribers are told right away instead of missing the signal
+    if (alreadyReceived && callback) {
+        callback();
+    }
+}
+
+M1OrientationClientStats M1OrientationClient::getStats() {
+    M1_ORIENTATION_RT_API("getStats");
+    return stats.getStats();
+}
+
+void M1OrientationClient::resetStats() {
+    M1_ORIENTATION_RT_API("resetStats");
+    stats.reset();
+}
+
+void M1OrientationClient::setSampleAgeAtReadEnabled(bool enable) {
+    M1_ORIENTATION_RT_API("setSampleAgeAtReadEnabled");
+    stats.setSampleAgeAtReadEnabled(enable);
+}
 
+void M1OrientationClient::setStatsDumpInterval(int intervalMillis, std::function<void(const M1OrientationClientStats& stats)> callback) {
+    M1_ORIENTATION_RT_API("setStatsDumpInterval");
+    mutex.lock();
+    statsDumpIntervalMillis = intervalMillis;
+    statsDumpCallback = callback;
+    mutex.unlock();
+}
+
+void M1OrientationClient::dumpStatsIfNeeded() {
+    mutex.lock();
+    int intervalMillis = statsDumpIntervalMillis;
+    auto callback = statsDumpCallback;
+    mutex.unlock();
+
+    juce::uint32 now = juce::Time::getMillisecondCounter();
+    if (intervalMillis <= 0 || now - lastStatsDumpMillis < (juce::uint32)intervalMillis) {
+        return;
+    }
+    lastStatsDumpMillis = now;
+
+    M1OrientationClientStats currentStats = stats.getStats();
+    if (callback) {
+        callback(currentStats);
+    } else {
+        DBG("[M1OrientationClient] ping p50/p99: " + std::to_string(currentStats.pingRoundTrip.p50Micros) + "/" + std::to_string(currentStats.pingRoundTrip.p99Micros) + "us"
+            + " parse p50/p99: " + std::to_string(currentStats.parseDuration.p50Micros) + "/" + std::to_string(currentStats.parseDuration.p99Micros) + "us"
+            + " sample age p50/p99: " + std::to_string(currentStats.sampleAgeAtRead.p50Micros) + "/" + std::to_string(currentStats.sampleAgeAtRead.p99Micros) + "us"
+            + " updates/s: " + std::to_string(currentStats.updatesPerSecond)
+            + " samples rejected/renormalized: " + std::to_string(currentStats.samplesRejected) + "/" + std::to_string(currentStats.samplesRenormalized)
+            + " commands ok/failed/timeout: " + std::to_string(currentStats.commandsSucceeded) + "/" + std::to_string(currentStats.commandsFailed) + "/" + std::to_string(currentStats.commandTimeouts));
+    }
+}
+
+bool M1OrientationClient::startRecording(std::string traceFilePath) {
+    M1_ORIENTATION_RT_API("startRecording");
+    M1_ORIENTATION_RT_SYSCALL(); // file I/O
+    std::lock_guard<M1OrientationMutex> lock(traceMutex);
+    if (!traceWriter.open(traceFilePath)) {
+        return false;
+    }
+    recording = true;
     return true;
 }
 
+void M1OrientationClient::stopRecording() {
+    M1_ORIENTATION_RT_API("stopRecording");
+    M1_ORIENTATION_RT_SYSCALL(); // file I/O
+    std::lock_guard<M1OrientationMutex> lock(traceMutex);
+    recording = false;
+    traceWriter.close();
+}
+
+bool M1OrientationClient::isRecording() {
+    M1_ORIENTATION_RT_API("isRecording");
+    return recording;
+}
+
+void M1OrientationClient::recordTraceSample(juce::uint32 flags, M1OrientationDeviceHandle handle, const Mach1::Orientation& orientation, juce::uint32 sequence, juce::int64 timestampMicros) {
+    Mach1::Quaternion quaternion = orientation.GetGlobalRotationAsQuaternion();
+    M1OrientationTraceRecord record;
+    record.timestampMicros = timestampMicros;
+    record.sequence = sequence;
+    record.flags = flags;
+    record.quaternion[0] = quaternion.w;
+    record.quaternion[1] = quaternion.x;
+    record.quaternion[2] = quaternion.y;
+    record.quaternion[3] = quaternion.z;
+    record.deviceHandle = handle;
+
+    std::lock_guard<M1OrientationMutex> lock(traceMutex);
+    traceWriter.write(record);
+}
+
+bool M1OrientationClient::startReplay(std::string traceFilePath, double speed, bool loop) {
+    M1_ORIENTATION_RT_API("startReplay");
+    M1_ORIENTATION_RT_SYSCALL(); // file I/O
+    auto reader = std::make_unique<M1OrientationTraceReader>();
+    if (!reader->open(traceFilePath) || reader->size() == 0 || speed <= 0) {
+        return false;
+    }
+    std::lock_guard<M1OrientationMutex> lock(traceMutex);
+    replayStopRequested = false; // a stop requested before this start doesn't apply to it
+    pendingReplay = std::move(reader);
+    pendingReplaySpeed = speed;
+    pendingReplayLoop = loop;
+    replaying = true;
+    return true;
+}
+
+void M1OrientationClient::stopReplay() {
+    M1_ORIENTATION_RT_API("stopReplay");
+    std::lock_guard<M1OrientationMutex> lock(traceMutex);
+    replayStopRequested = true;
+}
+
+bool M1OrientationClient::isReplaying() {
+    M1_ORIENTATION_RT_API("isReplaying");
+    return replaying;
+}
+
+int M1OrientationClient::stepReplay() {
+    // Returns how long to sleep until the next recorded sample is due, or -1 when not replaying
+    {
+        // The stop is handled first and under the lock, so it only cancels replays started before it
+        std::lock_guard<M1OrientationMutex> lock(traceMutex);
+        if (replayStopRequested.exchange(false)) {
+            replayReader.reset();
+            pendingReplay.reset();
+        }
+        if (pendingReplay) {
+            replayReader = std::move(pendingReplay);
+            replaySpeed = pendingReplaySpeed;
+            replayLoop = pendingReplayLoop;
+            replayIndex = 0;
+            replaySessionIndex = 0;
+            replayStartMicros = M1OrientationStats::nowMicros();
+            replaySessionStartMicros = (*replayReader)[0].timestampMicros;
+        }
+    }
+    if (!replayReader) {
+        replaying = false;
+        return -1;
+    }
+
+    M1_ORIENTATION_TRACE_SPAN("replay");
+    const M1OrientationTraceReader& trace = *replayReader;
+    int64_t now = M1OrientationStats::nowMicros();
+    // Client time at which a record of the current session is due
+    auto dueMicros = [this](const M1OrientationTraceRecord& record) {
+        return replayStartMicros + (int64_t)((record.timestampMicros - replaySessionStartMicros) / replaySpeed);
+    };
+
+    while (replayIndex < trace.size()) {
+        const M1OrientationTraceRecord& record = trace[replayIndex];
+        if ((record.flags & M1OrientationTraceRecord::SessionStart) && replayIndex != replaySessionIndex) {
+            // An appended session has its own clock origin, it starts when the previous one ended
+            replayStartMicros = dueMicros(trace[replayIndex - 1]);
+            replaySessionStartMicros = record.timestampMicros;
+            replaySessionIndex = replayIndex;
+        }
+        int64_t recordMicros = dueMicros(record);
+        if (recordMicros > now) {
+            break;
+        }
+        replayIndex++;
+        // Traces are files and may be damaged or hand made, records get the same finite / unit norm
+        // check as received samples and rejected ones leave the last good orientation published
+        Mach1::Orientation orientation;
+        bool accepted = ingestSample(replayAdapter, record.quaternion, 4, orientation);
+
+        if (record.flags & M1OrientationTraceRecord::MainOrientation) {
+            if (accepted) {
+                M1OrientationHistorySample sample = { record.sequence, recordMicros, orientation.GetGlobalRotationAsQuaternion() };
+                publishOrientations(&sample, 1);
+                stats.recordSampleReceived(now);
+            }
+            const bool recordedTrackingFlags[6] = {
+                (record.flags & M1OrientationTraceRecord::TrackingYawEnabled) != 0,
+                (record.flags & M1OrientationTraceRecord::TrackingPitchEnabled) != 0,
+                (record.flags & M1OrientationTraceRecord::TrackingRollEnabled) != 0,
+                (record.flags & M1OrientationTraceRecord::TrackingYawInverted) != 0,
+                (record.flags & M1OrientationTraceRecord::TrackingPitchInverted) != 0,
+                (record.flags & M1OrientationTraceRecord::TrackingRollInverted) != 0,
+            };
+            if (setTrackingFlags(recordedTrackingFlags)) {
+                stateGeneration++;
+            }
+            if (accepted && !hasFirstSample) {
+                signalFirstSample();
+            }
+        }
+        if (accepted && (record.flags & M1OrientationTraceRecord::DeviceStream)) {
+            // Keeps the recorded spacing between samples so fusion sees the original timing
+            if (publishDeviceStream(record.deviceHandle, orientation, recordMicros)) {
+                deviceStreamsFrame++;
+            }
+        }
+    }
+
+    if (replayIndex >= trace.size()) {
+        if (!replayLoop) {
+            replayReader.reset();
+            replaying = false;
+            return 0;
+        }
+        replayIndex = 0;
+        replaySessionIndex = 0;
+        replayStartMicros = now;
+        replaySessionStartMicros = trace[0].timestampMicros;
+        return 0;
+    }
+
+    int64_t untilNextMicros = dueMicros(trace[replayIndex]) - now;
+    return (int)std::min<int64_t>(untilNextMicros / 1000, POLL_INTERVAL_MS);
+}
+
+M1OrientationClientStartupTimings M1OrientationClient::getStartupTimings() {
+    M1_ORIENTATION_RT_API("getStartupTimings");
+    M1OrientationClientStartupTimings startupTimings;
+    startupTimings.initDurationMillis = initDurationMillis;
+    startupTimings.firstServerResponseMillis = firstServerResponseMillis;
+    startupTimings.firstSampleMillis = firstSampleMillis;
+    return startupTimings;
+}
+
+void M1OrientationClient::beginSessionRestore() {
+    sessionRestorePending = true;
+    sessionRestoreStartedMillis = juce::Time::getMillisecondCounter();
+    sessionRestoreDeviceSentMillis = 0;
+    sessionRestoreFlagsSent = false;
+
+    mutex.lock();
+    bool hasSubscriptions = !subscribedDevices.empty();
+    mutex.unlock();
+    if (hasSubscriptions) {
+        sendDeviceSubscriptions();
+    }
+}
+
+bool M1OrientationClient::restoreSession(const std::vector<M1OrientationDeviceInfo>& serverDevices, M1OrientationDeviceInfo serverCurrentDevice, const bool serverTrackingFlags[6]) {
+    // Returns true once the server reflects this client's cached session (or restoring gave up)
+    juce::uint32 now = juce::Time::getMillisecondCounter();
+
+    const bool cachedTrackingFlags[6] = {
+        bTrackingYawEnabled, bTrackingPitchEnabled, bTrackingRollEnabled,
+        bTrackingYawInverted, bTrackingPitchInverted, bTrackingRollInverted,
+    };
+    static const char* trackingFlagPaths[6] = {
+        "/setTrackingYawEnabled", "/setTrackingPitchEnabled", "/setTrackingRollEnabled",
+        "/setTrackingYawInverted", "/setTrackingPitchInverted", "/setTrackingRollInverted",
+    };
+
+    bool flagsRestored = true;
+    for (int i = 0; i < 6; i++) {
+        if (cachedTrackingFlags[i] != serverTrackingFlags[i]) {
+            flagsRestored = false;
+            if (!sessionRestoreFlagsSent) {
+                send(trackingFlagPaths[i], nlohmann::json({ cachedTrackingFlags[i] }).dump());
+            }
+        }
+    }
+    sessionRestoreFlagsSent = true;
+
+    mutex.lock();
+    M1OrientationDeviceInfo cachedDevice = currentDevice;
+    mutex.unlock();
+
+    bool deviceRestored = cachedDevice.getDeviceType() == M1OrientationManagerDeviceTypeNone || serverCurrentDevice == cachedDevice;
+    if (!deviceRestored) {
+        // Wait for the server to list the device again before asking for it, then resend at a slow rate
+        bool listed = std::find(serverDevices.begin(), serverDevices.end(), cachedDevice) != serverDevices.end();
+        if ((listed || sessionRestoreDeviceSentMillis == 0) && now - sessionRestoreDeviceSentMillis >= SESSION_RESTORE_RESEND_MS) {
+            send("/startTrackingUsingDevice", nlohmann::json({ cachedDevice.getDeviceName(), (int)cachedDevice.getDeviceType(), cachedDevice.getDeviceAddress() }).dump());
+            sessionRestoreDeviceSentMillis = now;
+        }
+    }
+
+    if ((flagsRestored && deviceRestored) || now - sessionRestoreStartedMillis >= SESSION_RESTORE_TIMEOUT_MS) {
+        sessionRestorePending = false;
+        return true;
+    }
+    return false;
+}
+
 void M1OrientationClient::command_refresh()
 {
+    M1_ORIENTATION_RT_API("command_refresh");
     send("/devicesrefresh", "");
 }
 
 std::vector<M1OrientationDeviceInfo> M1OrientationClient::getDevices() {
+    M1_ORIENTATION_RT_API("getDevices");
+    M1_ORIENTATION_TRACE_SPAN("getDevices");
     mutex.lock();
     std::vector<M1OrientationDeviceInfo> devices = this->devices;
     mutex.unlock();
@@ -268,28 +934,323 @@ std::vector<M1OrientationDeviceInfo> M1OrientationClient::getDevices() {
 }
 
 M1OrientationDeviceInfo M1OrientationClient::getCurrentDevice() {
+    M1_ORIENTATION_RT_API("getCurrentDevice");
     mutex.lock();
     M1OrientationDeviceInfo currentDevice = this->currentDevice;
     mutex.unlock();
     return currentDevice;
 }
 
+M1OrientationDeviceType M1OrientationClient::getCurrentDeviceType() {
+    M1_ORIENTATION_RT_API("getCurrentDeviceType");
+    return currentDeviceType.load(std::memory_order_acquire);
+}
+
+bool M1OrientationClient::findDevice(M1OrientationDeviceHandle handle, M1OrientationDeviceInfo& device) {
+    M1_ORIENTATION_RT_API("findDevice");
+    std::lock_guard<M1OrientationMutex> lock(mutex);
+    const M1OrientationDeviceInfo* listedDevice = findListedDevice(handle);
+    if (listedDevice == nullptr) {
+        return false;
+    }
+    device = *listedDevice;
+    return true;
+}
+
+bool M1OrientationClient::findDevice(const std::string& name, const std::string& address, M1OrientationDeviceInfo& device) {
+    M1_ORIENTATION_RT_API("findDevice");
+    return findDevice(M1OrientationDeviceInfo::findDeviceHandle(name, address), device);
+}
+
+void M1OrientationClient::pruneConventionAdapters() {
+    for (auto it = conventionAdapters.begin(); it != conventionAdapters.end();) {
+        it = deviceIndex.find(it->first) < 0 ? conventionAdapters.erase(it) : std::next(it);
+    }
+}
+
+const M1OrientationDeviceInfo* M1OrientationClient::findListedDevice(M1OrientationDeviceHandle handle) {
+    int index = deviceIndex.find(handle);
+    if (index < 0 || index >= (int)devices.size()) {
+        return nullptr;
+    }
+    return &devices[index];
+}
+
+bool M1OrientationClient::command_startTrackingUsingDevice(M1OrientationDeviceHandle handle) {
+    M1_ORIENTATION_RT_API("command_startTrackingUsingDevice");
+    M1OrientationDeviceInfo device;
+    if (!findDevice(handle, device)) {
+        return false;
+    }
+    command_startTrackingUsingDevice(device);
+    return true;
+}
+
 void M1OrientationClient::command_startTrackingUsingDevice(M1OrientationDeviceInfo device) {
+    M1_ORIENTATION_RT_API("command_startTrackingUsingDevice");
+    // An explicit selection replaces whatever session was being restored
+    sessionRestorePending = false;
     mutex.lock();
-    if (currentDevice != device) {
+    // Send the server's latest info for the device (e.g. its current type) when it is listed
+    const M1OrientationDeviceInfo* listedDevice = findListedDevice(device.getDeviceHandle());
+    if (listedDevice != nullptr && *listedDevice == device) {
+        device = *listedDevice;
+    }
+    bool changed = currentDevice != device;
+    mutex.unlock();
+
+    // Sent outside the lock, locked readers must not wait on the network
+    if (changed) {
         send("/startTrackingUsingDevice", nlohmann::json({ device.getDeviceName(), (int)device.getDeviceType(), device.getDeviceAddress() }).dump());
     }
+}
+
+bool M1OrientationClient::command_subscribeToDevice(M1OrientationDeviceInfo device) {
+    M1_ORIENTATION_RT_API("command_subscribeToDevice");
+    M1OrientationDeviceHandle handle = device.getDeviceHandle();
+    mutex.lock();
+    if (std::find(subscribedDevices.begin(), subscribedDevices.end(), device) != subscribedDevices.end()) {
+        mutex.unlock();
+        return true;
+    }
+    DeviceStream* stream = findDeviceStream(M1OrientationDeviceHandleNone);
+    if (stream == nullptr) {
+        mutex.unlock();
+        return false; // all MAX_DEVICE_STREAMS slots are in use
+    }
+    stream->subscribedAtVersion = stream->orientation.getVersion(); // older samples belong to a previous subscriber
+    stream->handle = handle;
+    subscribedDevices.push_back(device);
     mutex.unlock();
+
+    sendDeviceSubscriptions();
+    return true;
+}
+
+void M1OrientationClient::command_unsubscribeFromDevice(M1OrientationDeviceInfo device) {
+    M1_ORIENTATION_RT_API("command_unsubscribeFromDevice");
+    mutex.lock();
+    auto it = std::find(subscribedDevices.begin(), subscribedDevices.end(), device);
+    if (it == subscribedDevices.end()) {
+        mutex.unlock();
+        return;
+    }
+    subscribedDevices.erase(it);
+    DeviceStream* stream = findDeviceStream(device.getDeviceHandle());
+    if (stream != nullptr) {
+        // The polling thread may be publishing into this slot right now, it frees the slot itself
+        stream->releasing = true;
+        deviceStreamsReleasing = true;
+    }
+    mutex.unlock();
+
+    sendDeviceSubscriptions();
+}
+
+void M1OrientationClient::sendDeviceSubscriptions() {
+    nlohmann::json subscriptions = nlohmann::json::array();
+    mutex.lock();
+    for (auto& device : subscribedDevices) {
+        subscriptions.push_back({ device.getDeviceName(), (int)device.getDeviceType(), device.getDeviceAddress() });
+    }
+    mutex.unlock();
+    send("/subscribeDevices", subscriptions.dump());
+}
+
+bool M1OrientationClient::publishDeviceStream(M1OrientationDeviceHandle handle, const Mach1::Orientation& orientation, juce::int64 timestampMicros) {
+    DeviceStream* stream = findDeviceStream(handle);
+    if (stream == nullptr) {
+        return false;
+    }
+    stream->orientation.publish(orientation);
+    if (recording && !replaying) {
+        recordTraceSample(M1OrientationTraceRecord::DeviceStream, handle, orientation, receivedSequence, timestampMicros);
+    }
+
+    // Fusion runs on the polling thread only, at the rate of its IMU source
+    if (fusionResetRequested.exchange(false)) {
+        fusion.reset();
+    }
+    if (handle == fusionImuHandle) {
+        fusedOrientation.publish(fusion.addImuSample(orientation, timestampMicros));
+    } else if (handle == fusionReferenceHandle) {
+        fusion.addReferenceSample(orientation, timestampMicros);
+    }
+    return true;
+}
+
+M1OrientationClient::DeviceStream* M1OrientationClient::findDeviceStream(M1OrientationDeviceHandle handle) {
+    // Slots being released match neither their old device nor a free slot lookup
+    for (int i = 0; i < MAX_DEVICE_STREAMS; i++) {
+        if (deviceStreams[i].handle.load(std::memory_order_acquire) == handle && !deviceStreams[i].releasing.load(std::memory_order_acquire)) {
+            return &deviceStreams[i];
+        }
+    }
+    return nullptr;
+}
+
+void M1OrientationClient::recycleDeviceStreams() {
+    // Polling thread only, called between publishes
+    if (!deviceStreamsReleasing.exchange(false)) {
+        return;
+    }
+    std::lock_guard<M1OrientationMutex> lock(mutex);
+    for (auto& stream : deviceStreams) {
+        if (stream.releasing) {
+            stream.handle = M1OrientationDeviceHandleNone;
+            stream.releasing = false;
+        }
+    }
+}
+
+std::vector<M1OrientationDeviceInfo> M1OrientationClient::getSubscribedDevices() {
+    M1_ORIENTATION_RT_API("getSubscribedDevices");
+    mutex.lock();
+    std::vector<M1OrientationDeviceInfo> subscribedDevices = this->subscribedDevices;
+    mutex.unlock();
+    return subscribedDevices;
+}
+
+bool M1OrientationClient::getDeviceOrientation(M1OrientationDeviceHandle handle, Mach1::Orientation& orientation) {
+    M1_ORIENTATION_RT_API("getDeviceOrientation");
+    if (handle == M1OrientationDeviceHandleNone) {
+        return false;
+    }
+    DeviceStream* stream = findDeviceStream(handle);
+    if (stream == nullptr || stream->orientation.getVersion() == stream->subscribedAtVersion) {
+        return false; // not subscribed or nothing received yet
+    }
+    orientation = stream->orientation.read();
+    return true;
+}
+
+juce::uint32 M1OrientationClient::getDeviceStreamsFrame() {
+    M1_ORIENTATION_RT_API("getDeviceStreamsFrame");
+    return deviceStreamsFrame;
+}
+
+int M1OrientationClient::addDeviceListListener(std::function<void(const std::vector<M1OrientationDeviceEvent>& events)> listener) {
+    M1_ORIENTATION_RT_API("addDeviceListListener");
+    std::lock_guard<M1OrientationMutex> lock(mutex);
+    int listenerId = nextDeviceListListenerId++;
+    deviceListListeners[listenerId] = listener;
+    return listenerId;
+}
+
+void M1OrientationClient::removeDeviceListListener(int listenerId) {
+    M1_ORIENTATION_RT_API("removeDeviceListListener");
+    std::lock_guard<M1OrientationMutex> lock(mutex);
+    deviceListListeners.erase(listenerId);
+}
+
+juce::uint32 M1OrientationClient::getStateGeneration() {
+    M1_ORIENTATION_RT_API("getStateGeneration");
+    return stateGeneration;
+}
+
+juce::uint32 M1OrientationClient::getOrientationVersion() {
+    M1_ORIENTATION_RT_API("getOrientationVersion");
+    return m_orientation.getVersion();
+}
+
+bool M1OrientationClient::setTrackingFlags(const bool trackingFlags[6]) {
+    // Returns true if any flag changed
+    bool changed = bTrackingYawEnabled != trackingFlags[0] || bTrackingPitchEnabled != trackingFlags[1] || bTrackingRollEnabled != trackingFlags[2]
+        || bTrackingYawInverted != trackingFlags[3] || bTrackingPitchInverted != trackingFlags[4] || bTrackingRollInverted != trackingFlags[5];
+    bTrackingYawEnabled = trackingFlags[0];
+    bTrackingPitchEnabled = trackingFlags[1];
+    bTrackingRollEnabled = trackingFlags[2];
+    bTrackingYawInverted = trackingFlags[3];
+    bTrackingPitchInverted = trackingFlags[4];
+    bTrackingRollInverted = trackingFlags[5];
+    return changed;
+}
+
+bool M1OrientationClient::setFusionSources(M1OrientationDeviceInfo imuDevice, M1OrientationDeviceInfo referenceDevice) {
+    M1_ORIENTATION_RT_API("setFusionSources");
+    clearFusionSources();
+
+    // Streams the caller subscribed to itself are left alone when fusion is cleared
+    mutex.lock();
+    bool imuWasSubscribed = std::find(subscribedDevices.begin(), subscribedDevices.end(), imuDevice) != subscribedDevices.end();
+    bool referenceWasSubscribed = std::find(subscribedDevices.begin(), subscribedDevices.end(), referenceDevice) != subscribedDevices.end();
+    mutex.unlock();
+
+    if (!command_subscribeToDevice(imuDevice)) {
+        return false;
+    }
+    if (!command_subscribeToDevice(referenceDevice)) {
+        if (!imuWasSubscribed) {
+            command_unsubscribeFromDevice(imuDevice);
+        }
+        return false;
+    }
+
+    mutex.lock();
+    if (!imuWasSubscribed) {
+        fusionSubscriptions.push_back(imuDevice);
+    }
+    if (!referenceWasSubscribed && referenceDevice != imuDevice) {
+        fusionSubscriptions.push_back(referenceDevice);
+    }
+    mutex.unlock();
+
+    fusionImuHandle = imuDevice.getDeviceHandle();
+    fusionReferenceHandle = referenceDevice.getDeviceHandle();
+    fusionResetRequested = true;
+    return true;
+}
+
+void M1OrientationClient::clearFusionSources() {
+    M1_ORIENTATION_RT_API("clearFusionSources");
+    fusionImuHandle = M1OrientationDeviceHandleNone;
+    fusionReferenceHandle = M1OrientationDeviceHandleNone;
+    fusionResetRequested = true;
+
+    mutex.lock();
+    std::vector<M1OrientationDeviceInfo> subscriptions;
+    subscriptions.swap(fusionSubscriptions);
+    mutex.unlock();
+    for (auto& device : subscriptions) {
+        command_unsubscribeFromDevice(device);
+    }
+}
+
+bool M1OrientationClient::isFusionActive() {
+    M1_ORIENTATION_RT_API("isFusionActive");
+    return fusionImuHandle != M1OrientationDeviceHandleNone && fusedOrientation.getVersion() > 0;
+}
+
+Mach1::Orientation M1OrientationClient::getFusedOrientation() {
+    M1_ORIENTATION_RT_API("getFusedOrientation");
+    return fusedOrientation.read();
 }
 
 void M1OrientationClient::command_disconnect()
 {
+    M1_ORIENTATION_RT_API("command_disconnect");
+    sessionRestorePending = false;
     send("/disconnect", "");
 }
 
 void M1OrientationClient::close() {
-    isRunning = false;
-    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    M1_ORIENTATION_RT_API("close");
+    M1_ORIENTATION_RT_SYSCALL(); // waits for the polling thread to exit
+    {
+        std::lock_guard<M1OrientationMutex> lock(firstSampleMutex);
+        isRunning = false;
+    }
+    firstSampleCondition.notify_all();
+    // The polling thread finishes its current poll (at most a few request timeouts) before `this` goes away
+    if (pollThread.joinable()) {
+        if (pollThread.get_id() != std::this_thread::get_id()) {
+            pollThread.join();
+        } else {
+            pollThread.detach(); // closed from one of our own callbacks, the loop exits when it returns
+        }
+    }
+    stopRecording();
+    settingsWatcher.stop();
 }
 
 M1OrientationClient::~M1OrientationClient() {
@@ -297,11 +1258,5 @@ M1OrientationClient::~M1OrientationClient() {
 }
 
 void M1OrientationClient::setConnectedToServer(bool connected) {
-    std::lock_guard<std::mutex> lock(connectionMutex);
-    connectedToServer = connected;
-}
-
-bool M1OrientationClient::isConnectedToServer() {
-    std::lock_guard<std::mutex> lock(connectionMutex);
-    return connectedToServer;
+    connectedToServer.store(connected, std::memory_order_release);
 }
@@ -2,33 +2,114 @@
 
 #include <JuceHeader.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+
 #include "M1OrientationTypes.h"
 #include "M1OrientationSettings.h"
+#include "M1OrientationProtocol.h"
+#include "M1OrientationSnapshot.h"
+#include "M1OrientationFusion.h"
+#include "M1OrientationBatchRotation.h"
+#include "M1OrientationTransform.h"
+#include "M1OrientationConventionAdapter.h"
+#include "M1OrientationHistory.h"
+#include "M1OrientationClockSync.h"
+#include "M1OrientationStats.h"
+#include "M1OrientationTrace.h"
+#include "M1OrientationTracing.h"
+#include "M1OrientationRealtimeAudit.h"
 
 #include "libs/httplib/httplib.h"
 #include "m1_mathematics/Orientation.h"
 
-#ifndef PI
-#define PI       3.14159265358979323846
-#endif
+// Milliseconds measured from the start of init(), 0 until the step has happened
+struct M1OrientationClientStartupTimings {
+    double initDurationMillis = 0;
+    double firstServerResponseMillis = 0;
+    double firstSampleMillis = 0;
+};
 
 class M1OrientationClient :
     private juce::OSCReceiver::Listener<juce::OSCReceiver::RealtimeCallback>,
     public M1OrientationManagerOSCSettings
 {
-    std::mutex mutex;
-    std::mutex connectionMutex;
-    bool isRunning;
-    bool connectedToServer = false;
+    M1OrientationMutex mutex;
+    std::atomic<bool> isRunning { false };
+    std::thread pollThread; // started by init(), joined by close()
+    std::atomic<bool> connectedToServer { false };
 
     juce::OSCSender helperInterface;
-    int helperPort = 0;
-    int serverPort = 0;
+    std::atomic<int> helperPort { 0 };
+    std::atomic<int> serverPort { 0 };
+    std::string settingsFilePath; // empty uses getDefaultSettingsFilePath()
+    M1OrientationSettingsWatcher settingsWatcher;
 
     M1OrientationDeviceInfo currentDevice;
+    std::atomic<M1OrientationDeviceType> currentDeviceType { M1OrientationManagerDeviceTypeNone }; // mirrors `currentDevice` for the status queries
     std::vector<M1OrientationDeviceInfo> devices;
 
-    Mach1::Orientation m_orientation;
+    M1OrientationSnapshot<Mach1::Orientation> m_orientation; // after `transform`
+    M1OrientationSnapshot<Mach1::Orientation> rawOrientation; // as received
+    M1OrientationHistory history; // transformed samples, every sample of batching servers
+    std::vector<M1OrientationHistorySample> historyBatch; // polling thread only, reused per frame
+
+    // Client-side transform applied to the main orientation before it is published
+    M1OrientationMutex transformMutex;
+    std::unique_ptr<M1OrientationTransform> transform; // guarded by `transformMutex`, null publishes samples as received
+    std::atomic<bool> transformRecenterRequested { false };
+    std::atomic<bool> transformResetRequested { false };
+
+    // Per-device input conventions, applied once when samples are ingested
+    M1OrientationMutex conventionMutex;
+    std::vector<M1OrientationConventionRule> conventionRules; // guarded by `conventionMutex`
+    std::atomic<bool> conventionRulesChanged { false };
+    std::vector<M1OrientationConventionRule> activeConventionRules; // polling thread only
+    // Keyed by handle and resolved for the device's type, pruned to the listed devices when the list changes
+    struct CachedConventionAdapter {
+        bool resolved = false;
+        M1OrientationDeviceType type = M1OrientationManagerDeviceTypeNone;
+        M1OrientationConventionAdapter adapter;
+    };
+    std::unordered_map<M1OrientationDeviceHandle, CachedConventionAdapter> conventionAdapters; // polling thread only
+
+    // Multi-tracker support: one lock-free orientation per subscribed device, looked up by handle.
+    // Unsubscribed slots are only freed by the polling thread between publishes, so a slot handed to
+    // a new subscriber never receives a late sample of the device it was taken from.
+    static constexpr int MAX_DEVICE_STREAMS = 16;
+    struct DeviceStream {
+        std::atomic<M1OrientationDeviceHandle> handle { M1OrientationDeviceHandleNone };
+        M1OrientationSnapshot<Mach1::Orientation> orientation; // only published by the polling thread
+        std::atomic<juce::uint32> subscribedAtVersion { 0 };
+        std::atomic<bool> releasing { false }; // unsubscribed, waiting for the polling thread to free it
+    };
+    DeviceStream deviceStreams[MAX_DEVICE_STREAMS];
+    std::atomic<bool> deviceStreamsReleasing { false };
+    std::vector<M1OrientationDeviceInfo> subscribedDevices; // guarded by `mutex`
+
+    // handle -> index in `devices`, swapped in with the list, guarded by `mutex`
+    M1OrientationDeviceIndex deviceIndex;
+    M1OrientationDeviceIndex responseDeviceIndex; // polling thread only, index of the parsed list
+
+    M1OrientationPingResponse pingResponse; // polling thread only
+    M1OrientationClockSync clockSync; // polling thread only, server capture times to nowMicros()
+
+    // Device list changes, diffed per poll and handed to the listeners
+    std::vector<M1OrientationDeviceEvent> deviceEvents; // polling thread only
+    std::map<int, std::function<void(const std::vector<M1OrientationDeviceEvent>& events)>> deviceListListeners; // guarded by `mutex`
+    int nextDeviceListListenerId = 1; // guarded by `mutex`
+    std::atomic<juce::uint32> deviceStreamsFrame { 0 };
+    std::atomic<juce::uint32> stateGeneration { 0 }; // bumped when devices, current device or tracking flags change
+
+    // Client-side fusion of two device streams (M1OrientationManagerDeviceTypeFusion)
+    M1OrientationFusion fusion;
+    std::atomic<M1OrientationDeviceHandle> fusionImuHandle { M1OrientationDeviceHandleNone };
+    std::atomic<M1OrientationDeviceHandle> fusionReferenceHandle { M1OrientationDeviceHandleNone };
+    std::atomic<bool> fusionResetRequested { false };
+    std::vector<M1OrientationDeviceInfo> fusionSubscriptions; // guarded by `mutex`, made by setFusionSources() and undone by clearFusionSources()
+    M1OrientationSnapshot<Mach1::Orientation> fusedOrientation;
     bool bTrackingYawEnabled = true;
     bool bTrackingPitchEnabled = true;
     bool bTrackingRollEnabled = true;
@@ -41,8 +122,79 @@ class M1OrientationClient :
     int failedRequestCount = 0;
     static const int MAX_FAILED_REQUESTS = 3; // Adjust this value as needed
 
+    static constexpr int POLL_INTERVAL_MS = 30;
+    static constexpr int RECONNECT_POLL_INTERVAL_MS = 10; // faster polling while the server is away
+    static constexpr int HELPER_REQUEST_MIN_INTERVAL_MS = 30;
+    static constexpr int HELPER_REQUEST_MAX_INTERVAL_MS = 1000;
+    static constexpr int SESSION_RESTORE_TIMEOUT_MS = 10000;
+    static constexpr int SESSION_RESTORE_RESEND_MS = 500;
+
+    // Session state replayed to the server after it restarts
+    bool hasSessionState = false;
+    std::atomic<bool> sessionRestorePending { false };
+    juce::uint32 sessionRestoreStartedMillis = 0;
+    juce::uint32 sessionRestoreDeviceSentMillis = 0;
+    bool sessionRestoreFlagsSent = false;
+
+    // Cold start: signalled once the first orientation has been received after init()
+    M1OrientationMutex firstSampleMutex;
+    M1OrientationConditionVariable firstSampleCondition;
+    std::atomic<bool> hasFirstSample { false };
+    std::function<void()> firstSampleCallback = nullptr;
+    // Written by init() and the polling thread, read from any thread by getStartupTimings()
+    std::atomic<double> initStartedMillis { 0 };
+    std::atomic<double> initDurationMillis { 0 };
+    std::atomic<double> firstServerResponseMillis { 0 };
+    std::atomic<double> firstSampleMillis { 0 };
+
+    M1OrientationStats stats;
+    int statsDumpIntervalMillis = 0; // guarded by `mutex`
+    std::function<void(const M1OrientationClientStats& stats)> statsDumpCallback = nullptr; // guarded by `mutex`
+    juce::uint32 lastStatsDumpMillis = 0;
+
+    // Recording of received samples and replay of recorded traces through the same snapshots
+    M1OrientationMutex traceMutex;
+    std::atomic<bool> recording { false };
+    M1OrientationTraceWriter traceWriter; // guarded by `traceMutex`
+    std::unique_ptr<M1OrientationTraceReader> pendingReplay; // guarded by `traceMutex`, taken by the polling thread
+    double pendingReplaySpeed = 1.0;
+    bool pendingReplayLoop = false;
+    std::atomic<bool> replayStopRequested { false };
+    std::atomic<bool> replaying { false };
+    std::unique_ptr<M1OrientationTraceReader> replayReader; // owned by the polling thread
+    size_t replayIndex = 0;
+    // Client time and trace time at which the current recording session starts playing, appended
+    // sessions are played right after the one before them
+    size_t replaySessionIndex = 0;
+    int64_t replayStartMicros = 0;
+    int64_t replaySessionStartMicros = 0;
+    double replaySpeed = 1.0;
+    bool replayLoop = false;
+    M1OrientationConventionAdapter replayAdapter; // records are in client axes, only validated on replay
+    juce::uint32 receivedSequence = 0; // acknowledged to batching servers with /ping?since=
+
     void oscMessageReceived(const juce::OSCMessage& message) override;
 	void send(std::string path, std::string data);
+    void connectHelperInterface(int port);
+    void sendDeviceSubscriptions();
+    DeviceStream* findDeviceStream(M1OrientationDeviceHandle handle);
+    void recycleDeviceStreams();
+    bool publishDeviceStream(M1OrientationDeviceHandle handle, const Mach1::Orientation& orientation, juce::int64 timestampMicros);
+    void handlePingResponse(const std::string& body);
+    void publishOrientations(M1OrientationHistorySample* samples, std::size_t count);
+    void resetReceivedSamples(); // after a reconnect or a server restart
+    const M1OrientationConventionAdapter& getConventionAdapter(const M1OrientationDeviceInfo& device);
+    void pruneConventionAdapters(); // polling thread only, requires `mutex` for the device index
+    bool ingestSample(const M1OrientationDeviceInfo& device, const M1OrientationRawSample& sample, Mach1::Orientation& orientation);
+    bool ingestSample(const M1OrientationConventionAdapter& adapter, const float* values, int count, Mach1::Orientation& orientation);
+    void signalFirstSample();
+    bool setTrackingFlags(const bool trackingFlags[6]);
+    const M1OrientationDeviceInfo* findListedDevice(M1OrientationDeviceHandle handle); // requires `mutex`
+    void dumpStatsIfNeeded();
+    void recordTraceSample(juce::uint32 flags, M1OrientationDeviceHandle handle, const Mach1::Orientation& orientation, juce::uint32 sequence, juce::int64 timestampMicros);
+    int stepReplay();
+    void beginSessionRestore();
+    bool restoreSession(const std::vector<M1OrientationDeviceInfo>& serverDevices, M1OrientationDeviceInfo serverCurrentDevice, const bool serverTrackingFlags[6]);
     
 public:
     ~M1OrientationClient();
@@ -56,6 +208,7 @@ public:
 
     // Commands from a client to the server
     void command_startTrackingUsingDevice(M1OrientationDeviceInfo device);
+    bool command_startTrackingUsingDevice(M1OrientationDeviceHandle handle); // false if the device isn't listed
     void command_disconnect();
     void command_setTrackingYawEnabled(bool enable);
     void command_setTrackingPitchEnabled(bool enable);
@@ -66,30 +219,106 @@ public:
     void command_setAdditionalDeviceSettings(std::string additional_settings);
     void command_recenter();
     void command_refresh();
+    // Follow several devices at once, each has its own orientation stream
+    bool command_subscribeToDevice(M1OrientationDeviceInfo device);
+    void command_unsubscribeFromDevice(M1OrientationDeviceInfo device);
+    // Fuses a drifting high rate IMU with a drift-free reference (e.g. camera yaw), subscribes to both.
+    // Replaces the previous sources, subscriptions made for fusion are dropped again by clearFusionSources().
+    bool setFusionSources(M1OrientationDeviceInfo imuDevice, M1OrientationDeviceInfo referenceDevice);
+    void clearFusionSources();
 
     // Functions from the server to the clients
     std::vector<M1OrientationDeviceInfo> getDevices();
+    // O(1) lookups in the current device list
+    bool findDevice(M1OrientationDeviceHandle handle, M1OrientationDeviceInfo& device);
+    bool findDevice(const std::string& name, const std::string& address, M1OrientationDeviceInfo& device);
     M1OrientationDeviceInfo getCurrentDevice();
-    Mach1::Orientation getOrientation();
+    M1OrientationDeviceType getCurrentDeviceType(); // lock-free
+    Mach1::Orientation getOrientation(); // after the transform set with setTransform(), always a finite unit rotation
+    Mach1::Orientation getRawOrientation(); // as received from the server
+    // Recent transformed samples with their capture times (client receive times for servers that
+    // don't report them). Servers that batch deliver every sensor sample, not just the newest per poll.
+    // Sample times are capture times in M1OrientationStats::nowMicros() (server times mapped by M1OrientationClockSync)
+    std::size_t getOrientationHistory(M1OrientationHistorySample* samples, std::size_t maxCount); // lock-free, oldest first
+    bool getOrientationAt(juce::int64 timestampMicros, Mach1::Orientation& orientation); // lock-free, interpolated
+    // Rotates `count` direction vectors (separate x, y, z arrays) by the current orientation in one
+    // vectorized pass, see M1OrientationBatchRotation.h. Lock-free, outputs may alias the inputs.
+    void rotateDirections(const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, std::size_t count, bool inverse = false);
     bool getTrackingYawEnabled();
     bool getTrackingPitchEnabled();
     bool getTrackingRollEnabled();
     bool getTrackingYawInverted();
     bool getTrackingPitchInverted();
     bool getTrackingRollInverted();
+    std::vector<M1OrientationDeviceInfo> getSubscribedDevices();
+    bool getDeviceOrientation(M1OrientationDeviceHandle handle, Mach1::Orientation& orientation); // lock-free
+    juce::uint32 getDeviceStreamsFrame(); // increments once per received batch of device orientations
+    // Called from the polling thread with the devices added, removed or updated (signal, battery, status)
+    // since the previous poll, as handles and list positions. Read getDevices() once first, then apply
+    // the events; a removed device's index is its position in the list before. Returns an id for removal.
+    int addDeviceListListener(std::function<void(const std::vector<M1OrientationDeviceEvent>& events)> listener);
+    void removeDeviceListListener(int listenerId);
+
+    // Change notification for UIs: compare against the last seen value and only re-read state when it moved
+    juce::uint32 getStateGeneration(); // device list, current device and tracking flags
+    juce::uint32 getOrientationVersion(); // orientation snapshot
+    // Recenter, axis mask/invert, smoothing and convention stages run once per received sample on the
+    // polling thread (see M1OrientationTransform.h), e.g.
+    // setTransform(std::make_unique<M1OrientationPipeline<M1OrientationRecenterStage, M1OrientationSmoothingStage>>())
+    // Replaces the current transform and its state, nullptr publishes samples as received.
+    void setTransform(std::unique_ptr<M1OrientationTransform> transform);
+    void recenterTransform(); // applied with the next sample
+    // Declares the axes, euler units and quaternion order each device sends (see M1OrientationConventionAdapter.h),
+    // the first matching rule wins and unmatched devices use the orientation server's convention.
+    // Samples are converted once when received, orientations read from the client are always in client axes.
+    void setInputConventions(std::vector<M1OrientationConventionRule> rules);
+    bool isFusionActive();
+    Mach1::Orientation getFusedOrientation(); // lock-free, updated at the IMU rate
 
     // Connection handling
     int getServerPort();
     int getHelperPort();
     std::string getClientType();
     void setClientType(std::string client_type);
+    // Reads the ports from another settings.json (e.g. a test server's), must be set before init()
+    void setSettingsFilePath(std::string jsonSettingsFilePath);
     void setStatusCallback(std::function<void(bool success, std::string message, std::string connectedDeviceName, int connectedDeviceType, std::string connectedDeviceAddress)> callback);
     void close();
+
+    // Cold start handling, init() returns without waiting on the server
+    bool hasReceivedFirstSample();
+    bool waitForFirstSample(int timeoutMillis); // blocks, never call this from the audio or message thread
+    void setFirstSampleCallback(std::function<void()> callback); // called once from the polling thread
+    M1OrientationClientStartupTimings getStartupTimings();
+
+    // Instrumentation: ping round trip, parse time, sample age at read, update rate and command results
+    M1OrientationClientStats getStats();
+    void resetStats();
+    // Sample age at read is measured inside getOrientation() and costs atomic read-modify-writes on the
+    // calling thread, off by default. Enable it for profiling, not in shipping audio callbacks.
+    void setSampleAgeAtReadEnabled(bool enable);
+    // Periodically hands the stats to `callback` (or DBG when null) from the polling thread, 0 disables
+    void setStatsDumpInterval(int intervalMillis, std::function<void(const M1OrientationClientStats& stats)> callback = nullptr);
+
+    // Record every received sample to a binary trace (see M1OrientationTrace.h)
+    bool startRecording(std::string traceFilePath);
+    void stopRecording();
+    bool isRecording();
+    // Feed a recorded trace through the orientation snapshots instead of polling the server,
+    // `speed` > 1 replays faster than recorded
+    bool startReplay(std::string traceFilePath, double speed = 1.0, bool loop = false);
+    void stopReplay();
+    bool isReplaying();
     
+    // Status queries are wait-free, safe to call per audio block
     bool isConnectedToDevice() {
-        return getCurrentDevice().getDeviceType() != M1OrientationManagerDeviceTypeNone;
+        M1_ORIENTATION_RT_API("isConnectedToDevice");
+        return currentDeviceType.load(std::memory_order_acquire) != M1OrientationManagerDeviceTypeNone;
     }
 
     void setConnectedToServer(bool connected);
-    bool isConnectedToServer();
+    bool isConnectedToServer() {
+        M1_ORIENTATION_RT_API("isConnectedToServer");
+        return connectedToServer.load(std::memory_order_acquire);
+    }
 };
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// Maps capture timestamps reported by the server into the client's steady clock
+// (M1OrientationStats::nowMicros()), so server timestamps and the client's own receive times can be
+// mixed, e.g. by fusion and the orientation history.
+//
+// The offset is the smallest (receive time - capture time) seen over a sliding window: the clock
+// offset plus the lowest transport latency. Mapped timestamps are therefore never later than the
+// sample's arrival, and the window lets the offset follow clock drift or a restarted server.
+// Polling thread only.
+class M1OrientationClockSync
+{
+public:
+    static constexpr int64_t WINDOW_MICROS = 2000000;
+
+    void observe(int64_t serverMicros, int64_t receivedMicros) {
+        int64_t offset = receivedMicros - serverMicros;
+        if (!hasOffset) {
+            offsetMicros = windowMinMicros = offset;
+            windowStartMicros = receivedMicros;
+            hasOffset = true;
+            return;
+        }
+        windowMinMicros = std::min(windowMinMicros, offset);
+        offsetMicros = std::min(offsetMicros, offset); // a faster delivery tightens the offset right away
+        if (receivedMicros - windowStartMicros >= WINDOW_MICROS) {
+            offsetMicros = windowMinMicros;
+            windowMinMicros = offset;
+            windowStartMicros = receivedMicros;
+        }
+    }
+
+    // `serverMicros` in the client's clock, `receivedMicros` until an offset has been observed
+    int64_t toClientMicros(int64_t serverMicros, int64_t receivedMicros) const {
+        if (!hasOffset) {
+            return receivedMicros;
+        }
+        return std::min(serverMicros + offsetMicros, receivedMicros);
+    }
+
+    void reset() {
+        hasOffset = false;
+    }
+
+private:
+    bool hasOffset = false;
+    int64_t offsetMicros = 0;
+    int64_t windowMinMicros = 0;
+    int64_t windowStartMicros = 0;
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+
+#include "M1OrientationTypes.h"
+#include "M1OrientationTransform.h"
+
+#ifndef PI
+#define PI       3.14159265358979323846
+#endif
+
+// Outcome of converting one received orientation array, rejected samples are not published and
+// readers keep the last good orientation
+enum M1OrientationSampleStatus {
+    M1OrientationSampleValid = 0,
+    M1OrientationSampleRenormalized, // accepted, the quaternion was scaled back to unit length
+    M1OrientationSampleRejectedNonFinite, // NaN or infinity
+    M1OrientationSampleRejectedNorm, // quaternion too far from unit length to be a rotation
+    M1OrientationSampleRejectedShape // neither 3 nor 4 values
+};
+
+inline bool M1OrientationIsSampleAccepted(M1OrientationSampleStatus status) {
+    return status == M1OrientationSampleValid || status == M1OrientationSampleRenormalized;
+}
+
+// Orientation arrays as a device sends them: 3 values are euler yaw, pitch, roll and 4 values are a
+// quaternion, both in the device's own axes. The defaults describe what the orientation server sends.
+struct M1OrientationInputConvention {
+    enum EulerUnits {
+        EulerNormalized = 0, // -1..1 per axis for -PI..PI
+        EulerRadians,
+        EulerDegrees
+    };
+    enum QuaternionOrder {
+        QuaternionWXYZ = 0,
+        QuaternionXYZW
+    };
+
+    EulerUnits eulerUnits = EulerNormalized;
+    QuaternionOrder quaternionOrder = QuaternionWXYZ;
+    M1OrientationConvention convention; // device axes to client axes, applied to both euler and quaternion input
+    // Quaternions whose length is further than this from 1 are rejected, closer ones are renormalized
+    float maxQuaternionNormError = 0.1f;
+};
+
+// Declarative mapping of devices to their input convention, the first matching rule wins
+struct M1OrientationConventionRule {
+    M1OrientationDeviceType deviceType = M1OrientationManagerDeviceTypeNone; // None matches any type
+    std::string namePrefix; // empty matches any name
+    M1OrientationInputConvention input;
+
+    bool matches(const M1OrientationDeviceInfo& device) const {
+        return (deviceType == M1OrientationManagerDeviceTypeNone || device.getDeviceType() == deviceType)
+            && device.getDeviceName().compare(0, namePrefix.size(), namePrefix) == 0;
+    }
+};
+
+// An input convention precomputed for ingest: the signed axis permutation is folded into per-axis
+// scales and the basis change into a pair of conversion quaternions, so converting a sample is a
+// few multiplies with no per-sample decisions beyond the 3 / 4 value split.
+class M1OrientationConventionAdapter
+{
+public:
+    M1OrientationConventionAdapter() : M1OrientationConventionAdapter(M1OrientationInputConvention()) {}
+
+    explicit M1OrientationConventionAdapter(const M1OrientationInputConvention& input) {
+        const double eulerScales[3] = { PI, 1.0, PI / 180.0 };
+        eulerScale = (float)eulerScales[input.eulerUnits];
+        wLast = input.quaternionOrder == M1OrientationInputConvention::QuaternionXYZW;
+        maxNormError = input.maxQuaternionNormError;
+
+        const M1OrientationConvention& convention = input.convention;
+        convention.getVectorScales(scales);
+        for (int i = 0; i < 3; i++) {
+            axes[i] = convention.axes[i];
+        }
+        Mach1::Quaternion basis = M1OrientationQuaternion::normalize(convention.basis);
+        basisConjugate = M1OrientationQuaternion::conjugate(basis);
+        basisRotation = basis;
+        identity = convention.isIdentity();
+    }
+
+    // Validates and converts a raw orientation array, `orientation` is only written for accepted
+    // samples and is then always a finite unit quaternion
+    M1OrientationSampleStatus toOrientation(const float* values, int count, Mach1::Orientation& orientation) const {
+        if (count != 3 && count != 4) {
+            return M1OrientationSampleRejectedShape;
+        }
+        for (int i = 0; i < count; i++) {
+            if (!std::isfinite(values[i])) {
+                return M1OrientationSampleRejectedNonFinite;
+            }
+        }
+
+        M1OrientationSampleStatus status = M1OrientationSampleValid;
+        Mach1::Quaternion rotation;
+        if (count == 3) {
+            Mach1::Orientation euler;
+            euler.SetRotation(Mach1::Float3(values[0] * eulerScale, values[1] * eulerScale, values[2] * eulerScale));
+            rotation = euler.GetGlobalRotationAsQuaternion();
+        } else {
+            rotation = wLast ? Mach1::Quaternion(values[3], values[0], values[1], values[2]) : Mach1::Quaternion(values[0], values[1], values[2], values[3]);
+            float norm = std::sqrt(M1OrientationQuaternion::dot(rotation, rotation));
+            if (!std::isfinite(norm) || std::fabs(norm - 1.0f) > maxNormError || norm < MIN_QUATERNION_NORM) {
+                return M1OrientationSampleRejectedNorm;
+            }
+            if (std::fabs(norm - 1.0f) > RENORMALIZE_THRESHOLD) {
+                rotation = Mach1::Quaternion(rotation.w / norm, rotation.x / norm, rotation.y / norm, rotation.z / norm);
+                status = M1OrientationSampleRenormalized;
+            }
+        }
+        orientation.SetRotation(identity ? rotation : convert(rotation));
+        return status;
+    }
+
+    Mach1::Quaternion convert(const Mach1::Quaternion& rotation) const {
+        const float v[3] = { rotation.x, rotation.y, rotation.z };
+        Mach1::Quaternion mapped(rotation.w, scales[0] * v[axes[0]], scales[1] * v[axes[1]], scales[2] * v[axes[2]]);
+        return M1OrientationQuaternion::multiply(basisConjugate, M1OrientationQuaternion::multiply(mapped, basisRotation));
+    }
+
+private:
+    static constexpr float RENORMALIZE_THRESHOLD = 1e-4f; // float rounding from the sender is left alone
+    static constexpr float MIN_QUATERNION_NORM = 1e-3f;
+
+    float eulerScale = (float)PI;
+    float maxNormError = 0.1f;
+    bool wLast = false;
+    bool identity = true;
+    int axes[3] = { 0, 1, 2 };
+    float scales[3] = { 1.0f, 1.0f, 1.0f };
+    Mach1::Quaternion basisRotation = M1OrientationQuaternion::identity();
+    Mach1::Quaternion basisConjugate = M1OrientationQuaternion::identity();
+};
@@ -0,0 +1,115 @@
+#include "M1OrientationFusion.h"
+
+#include <cmath>
+
+static double wrapRadians(double angle) {
+    while (angle > PI) angle -= 2 * PI;
+    while (angle < -PI) angle += 2 * PI;
+    return angle;
+}
+
+// Hamilton product
+static Mach1::Quaternion multiplyQuaternions(const Mach1::Quaternion& a, const Mach1::Quaternion& b) {
+    return Mach1::Quaternion(a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+                             a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                             a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                             a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w);
+}
+
+static double getYawRadians(const Mach1::Orientation& orientation) {
+    return orientation.GetGlobalRotationAsEulerRadians().GetYaw();
+}
+
+static Mach1::Quaternion yawRotation(double yawRadians) {
+    // Built through Mach1::Orientation so the vertical axis matches the library's convention
+    Mach1::Orientation rotation;
+    rotation.SetRotation(Mach1::Float3((float)yawRadians, 0.0f, 0.0f));
+    return rotation.GetGlobalRotationAsQuaternion();
+}
+
+bool M1OrientationFusion::imuYawAt(int64_t timestampMicros, double& yaw) const {
+    if (imuHistory.empty()) {
+        return false;
+    }
+    if (timestampMicros <= imuHistory.front().timestampMicros) {
+        yaw = imuHistory.front().yaw;
+        return true;
+    }
+    for (size_t i = 1; i < imuHistory.size(); i++) {
+        const ImuYawSample& next = imuHistory[i];
+        if (timestampMicros <= next.timestampMicros) {
+            const ImuYawSample& previous = imuHistory[i - 1];
+            double t = (double)(timestampMicros - previous.timestampMicros) / (double)(next.timestampMicros - previous.timestampMicros);
+            yaw = wrapRadians(previous.yaw + wrapRadians(next.yaw - previous.yaw) * t);
+            return true;
+        }
+    }
+    yaw = imuHistory.back().yaw;
+    return true;
+}
+
+Mach1::Orientation M1OrientationFusion::addImuSample(const Mach1::Orientation& imu, int64_t timestampMicros) {
+    double dt = lastImuTimestampMicros > 0 ? (timestampMicros - lastImuTimestampMicros) / 1000000.0 : 0.0;
+    lastImuTimestampMicros = timestampMicros;
+
+    imuHistory.push_back({ timestampMicros, getYawRadians(imu) });
+    while (imuHistory.size() > 1 && timestampMicros - imuHistory.front().timestampMicros > (int64_t)(settings.maxImuHistorySeconds * 1000000.0)) {
+        imuHistory.pop_front();
+    }
+
+    // Blend in the outstanding yaw error as a first order low pass
+    if (dt > 0 && pendingYawError != 0) {
+        double alpha = 1.0 - std::exp(-dt / settings.referenceTimeConstantSeconds);
+        double step = pendingYawError * alpha;
+        yawCorrection = wrapRadians(yawCorrection + step);
+        pendingYawError -= step;
+    }
+
+    fused.SetRotation(multiplyQuaternions(yawRotation(yawCorrection), imu.GetGlobalRotationAsQuaternion()));
+    return fused;
+}
+
+void M1OrientationFusion::addReferenceSample(const Mach1::Orientation& reference, int64_t timestampMicros) {
+    if (lastImuTimestampMicros > 0 && lastImuTimestampMicros - timestampMicros > (int64_t)(settings.referenceTimeoutSeconds * 1000000.0)) {
+        return; // arrived too late to say anything about the current drift
+    }
+
+    // Compare against the IMU at the time the reference was captured, not at arrival
+    double imuYaw;
+    if (!imuYawAt(timestampMicros, imuYaw)) {
+        return;
+    }
+    double error = wrapRadians(getYawRadians(reference) - wrapRadians(imuYaw + yawCorrection));
+
+    if (!receivedReference) {
+        // First reference snaps so the output doesn't slowly swing into place on startup
+        yawCorrection = wrapRadians(yawCorrection + error);
+        pendingYawError = 0;
+        receivedReference = true;
+    } else {
+        pendingYawError = error;
+    }
+    lastReferenceTimestampMicros = timestampMicros;
+}
+
+Mach1::Orientation M1OrientationFusion::getFusedOrientation() const {
+    return fused;
+}
+
+double M1OrientationFusion::getYawCorrectionRadians() const {
+    return yawCorrection;
+}
+
+bool M1OrientationFusion::hasReference() const {
+    return receivedReference && lastImuTimestampMicros - lastReferenceTimestampMicros <= (int64_t)(settings.referenceTimeoutSeconds * 1000000.0);
+}
+
+void M1OrientationFusion::reset() {
+    imuHistory.clear();
+    fused = Mach1::Orientation();
+    lastImuTimestampMicros = 0;
+    lastReferenceTimestampMicros = 0;
+    receivedReference = false;
+    yawCorrection = 0;
+    pendingYawError = 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "m1_mathematics/Orientation.h"
+
+#ifndef PI
+#define PI       3.14159265358979323846
+#endif
+
+// Complementary filter combining a high rate source that drifts in yaw (IMU) with a
+// low rate drift-free reference (camera). Pitch and roll come from the IMU as-is, the
+// yaw drift is removed by a correction rotation about the vertical axis that slowly
+// follows the reference. Output is produced at the IMU rate.
+class M1OrientationFusion
+{
+public:
+    struct Settings {
+        double referenceTimeConstantSeconds = 1.0; // how quickly yaw converges on the reference
+        double maxImuHistorySeconds = 0.5; // covers the reference source's latency
+        double referenceTimeoutSeconds = 2.0; // stale reference samples are ignored after this
+    };
+
+    M1OrientationFusion() {}
+    M1OrientationFusion(Settings settings_) : settings(settings_) {}
+
+    // Timestamps are in microseconds on any monotonic clock shared by both sources
+    Mach1::Orientation addImuSample(const Mach1::Orientation& imu, int64_t timestampMicros);
+    void addReferenceSample(const Mach1::Orientation& reference, int64_t timestampMicros);
+
+    Mach1::Orientation getFusedOrientation() const;
+    double getYawCorrectionRadians() const;
+    bool hasReference() const;
+    void reset();
+
+    Settings settings;
+
+private:
+    struct ImuYawSample {
+        int64_t timestampMicros;
+        double yaw;
+    };
+
+    std::deque<ImuYawSample> imuHistory;
+    Mach1::Orientation fused;
+    int64_t lastImuTimestampMicros = 0;
+    int64_t lastReferenceTimestampMicros = 0;
+    bool receivedReference = false;
+    double yawCorrection = 0; // radians applied on top of the IMU yaw
+    double pendingYawError = 0; // radians still to be blended in
+
+    bool imuYawAt(int64_t timestampMicros, double& yaw) const;
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "M1OrientationTransform.h"
+
+struct M1OrientationHistorySample {
+    uint32_t sequence = 0;
+    int64_t timestampMicros = 0; // capture time in the client's clock, M1OrientationStats::nowMicros()
+    Mach1::Quaternion rotation;
+};
+
+// Ring of the most recent orientation samples, for interpolation and prediction between polls.
+// Single writer (the polling thread) appending a whole transport frame at once, any number of
+// lock-free readers. Like M1OrientationSnapshot, readers copy without locks and drop any slot
+// the writer may have been overwriting while it was copied.
+class M1OrientationHistory
+{
+public:
+    static constexpr std::size_t CAPACITY = 512;
+
+    // Appends `count` samples, oldest first, and publishes them together
+    void append(const M1OrientationHistorySample* samples, std::size_t count) {
+        if (count > CAPACITY) {
+            samples += count - CAPACITY;
+            count = CAPACITY;
+        }
+        uint64_t index = written.load(std::memory_order_relaxed);
+        writing.store(index + count, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < count; i++) {
+            std::memcpy((void*)&slots[(index + i) % CAPACITY], (const void*)&samples[i], sizeof(M1OrientationHistorySample));
+        }
+        written.store(index + count, std::memory_order_release);
+    }
+
+    // Drops every sample appended so far, e.g. when a restarted server's samples must not be
+    // interpolated with the previous server's. Readers already copying may still return them.
+    void clear() {
+        start.store(written.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    // Copies up to `maxCount` of the newest samples, oldest first, and returns how many were copied
+    std::size_t readLatest(M1OrientationHistorySample* out, std::size_t maxCount) const {
+        uint64_t end = written.load(std::memory_order_acquire);
+        uint64_t count = maxCount < CAPACITY ? maxCount : CAPACITY;
+        count = count < end - getStart(end) ? count : end - getStart(end);
+        uint64_t begin = end - count;
+        for (uint64_t i = begin; i < end; i++) {
+            std::memcpy((void*)&out[i - begin], (const void*)&slots[i % CAPACITY], sizeof(M1OrientationHistorySample));
+        }
+        // Slots below this may have been overwritten during the copy
+        uint64_t firstIntact = firstIntactIndex();
+        if (firstIntact <= begin) {
+            return (std::size_t)count;
+        }
+        if (firstIntact >= end) {
+            return 0;
+        }
+        std::memmove((void*)out, (const void*)&out[firstIntact - begin], (std::size_t)(end - firstIntact) * sizeof(M1OrientationHistorySample));
+        return (std::size_t)(end - firstIntact);
+    }
+
+    // Orientation at `timestampMicros`, interpolated between the two samples around it. Times
+    // before the oldest or after the newest sample return that sample, false while empty.
+    bool sampleAt(int64_t timestampMicros, Mach1::Quaternion& rotation) const {
+        uint64_t end = written.load(std::memory_order_acquire);
+        uint64_t begin = std::max(end > CAPACITY ? end - CAPACITY : 0, getStart(end));
+        M1OrientationHistorySample later, earlier;
+        bool hasLater = false;
+        // Walk back from the newest sample, usually only a few steps
+        for (uint64_t i = end; i > begin; i--) {
+            if (!readSlot(i - 1, earlier)) {
+                break;
+            }
+            if (earlier.timestampMicros <= timestampMicros) {
+                if (!hasLater || later.timestampMicros <= earlier.timestampMicros) {
+                    rotation = earlier.rotation;
+                } else {
+                    float t = (float)(timestampMicros - earlier.timestampMicros) / (float)(later.timestampMicros - earlier.timestampMicros);
+                    rotation = M1OrientationQuaternion::slerp(earlier.rotation, later.rotation, t);
+                }
+                return true;
+            }
+            later = earlier;
+            hasLater = true;
+        }
+        if (hasLater) {
+            rotation = later.rotation; // older than everything still held
+        }
+        return hasLater;
+    }
+
+    std::size_t size() const {
+        uint64_t end = written.load(std::memory_order_acquire);
+        uint64_t count = end - getStart(end);
+        return (std::size_t)(count < CAPACITY ? count : CAPACITY);
+    }
+
+private:
+    M1OrientationHistorySample slots[CAPACITY];
+    std::atomic<uint64_t> written { 0 }; // samples appended and published
+    std::atomic<uint64_t> writing { 0 }; // end of the batch being written
+    std::atomic<uint64_t> start { 0 }; // first sample appended since the last clear()
+
+    // Never past `end`, which the caller loaded before
+    uint64_t getStart(uint64_t end) const {
+        uint64_t first = start.load(std::memory_order_acquire);
+        return first < end ? first : end;
+    }
+
+    uint64_t firstIntactIndex() const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t writeEnd = writing.load(std::memory_order_relaxed);
+        return writeEnd > CAPACITY ? writeEnd - CAPACITY : 0;
+    }
+
+    bool readSlot(uint64_t index, M1OrientationHistorySample& sample) const {
+        std::memcpy((void*)&sample, (const void*)&slots[index % CAPACITY], sizeof(M1OrientationHistorySample));
+        return index >= firstIntactIndex();
+    }
+};
@@ -0,0 +1,530 @@
+#include "M1OrientationProtocol.h"
+
+#include <algorithm>
+#include <climits>
+
+#include "libs/json/single_include/nlohmann/json.hpp"
+
+// Orientation arrays from the server are either euler (3 values) or a quaternion (4 values), they are
+// converted by the client with the sending device's convention
+static bool parseOrientation(const float* raw, int count, M1OrientationRawSample& sample) {
+    if (count != 3 && count != 4) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        sample.values[i] = raw[i];
+    }
+    sample.count = count;
+    return true;
+}
+
+namespace {
+
+// Streams a /ping body straight into a M1OrientationPingResponse without building a JSON DOM,
+// so a poll only allocates when the response's vectors have to grow or a device string is new.
+// Mirrors what the DOM based parser accepted: missing or mistyped required fields fail the parse,
+// unknown keys are skipped.
+class PingResponseSaxHandler
+{
+public:
+    typedef nlohmann::json::number_integer_t number_integer_t;
+    typedef nlohmann::json::number_unsigned_t number_unsigned_t;
+    typedef nlohmann::json::number_float_t number_float_t;
+    typedef nlohmann::json::string_t string_t;
+
+    PingResponseSaxHandler(M1OrientationPingResponse& response_) : response(response_) {}
+
+    bool null() { return scalar(ValueNull); }
+    bool boolean(bool value) { booleanValue = value; numberValue = value ? 1 : 0; integerValue = value ? 1 : 0; return scalar(ValueBoolean); }
+    bool number_integer(number_integer_t value) { numberValue = (double)value; integerValue = value; return scalar(ValueNumber); }
+    bool number_unsigned(number_unsigned_t value) { numberValue = (double)value; integerValue = (int64_t)value; return scalar(ValueNumber); }
+    bool number_float(number_float_t value, const string_t&) { numberValue = value; integerValue = (int64_t)value; return scalar(ValueNumber); }
+    bool string(string_t& value) { stringValue = &value; return scalar(ValueString); }
+    template <typename Binary>
+    bool binary(Binary&) { return scalar(ValueOther); }
+
+    bool start_object(std::size_t) {
+        if (depth == 0) {
+            depth = 1;
+            return true;
+        }
+        if (field == FieldUnknown) {
+            return enter();
+        }
+        // Objects are only tolerated as (invalid) orientation values
+        if (isOrientationValue()) {
+            if ((field == FieldOrientation && depth == 2) || ((field == FieldDeviceOrientations || field == FieldSamples) && depth == 4)) {
+                valueCount++;
+            }
+            invalidValues = true;
+            nextPosition();
+            return enter();
+        }
+        return false;
+    }
+
+    bool end_object() {
+        return leave();
+    }
+
+    bool start_array(std::size_t) {
+        if (depth == 0) {
+            return false; // the body has to be an object
+        }
+        int position = nextPosition();
+        switch (field) {
+            case FieldDevices:
+                if (depth == 2) {
+                    deviceFieldCount = 0;
+                } else if (depth != 1) {
+                    return false;
+                }
+                break;
+            case FieldDeviceOrientations:
+                if (depth == 2) {
+                    deviceOrientation = M1OrientationPingResponse::DeviceOrientation();
+                    deviceOrientationFieldCount = 0;
+                    deviceOrientationValid = false;
+                    deviceOrientationTypeError = false;
+                    valueCount = 0;
+                    invalidValues = false;
+                } else if (depth == 3 && position == 1) {
+                    deviceOrientationFieldCount++;
+                    valueCount = 0;
+                    invalidValues = false;
+                } else if (depth >= 4) {
+                    if (depth == 4) {
+                        valueCount++;
+                    }
+                    invalidValues = true;
+                } else if (depth != 1) {
+                    return false;
+                }
+                break;
+            case FieldSamples:
+                // [sequence, timestampMicros, orientation]
+                if (depth == 2) {
+                    sample = M1OrientationPingResponse::Sample();
+                    sampleFieldCount = 0;
+                    valueCount = 0;
+                    invalidValues = true; // until the orientation array is read
+                } else if (depth == 3 && position == 2) {
+                    sampleFieldCount++;
+                    valueCount = 0;
+                    invalidValues = false;
+                } else if (depth >= 4) {
+                    if (depth == 4) {
+                        valueCount++;
+                    }
+                    invalidValues = true;
+                } else if (depth != 1) {
+                    return false;
+                }
+                break;
+            case FieldOrientation:
+                if (depth == 1) {
+                    valueCount = 0;
+                    invalidValues = false;
+                } else {
+                    if (depth == 2) {
+                        valueCount++;
+                    }
+                    invalidValues = true; // nested arrays are not orientations
+                }
+                break;
+            case FieldTrackingEnabled:
+            case FieldTrackingInverted:
+                if (depth != 1 && position < 3) {
+                    return false;
+                }
+                break;
+            case FieldCurrentDeviceIdx:
+            case FieldTimestampMicros:
+            case FieldSequence:
+                return false;
+            default:
+                break;
+        }
+        return enter();
+    }
+
+    bool end_array() {
+        switch (field) {
+            case FieldDevices:
+                if (depth == 3) {
+                    if (deviceFieldCount < 5) {
+                        return false;
+                    }
+                    response.devices.push_back(M1OrientationDeviceInfo(deviceNameId, (M1OrientationDeviceType)deviceType, deviceAddressId, deviceHasStrength ? deviceStrength : false));
+                }
+                break;
+            case FieldDeviceOrientations:
+                if (depth == 4) {
+                    deviceOrientationValid = !invalidValues && parseOrientation(values, valueCount, deviceOrientation.orientation);
+                    deviceOrientationTypeError = invalidValues && (valueCount == 3 || valueCount == 4);
+                } else if (depth == 3) {
+                    // [deviceIdx, orientation, optional capture timestamp in microseconds]
+                    if (deviceOrientationFieldCount < 2) {
+                        return false;
+                    }
+                    if (deviceOrientationValid) {
+                        response.deviceOrientations.push_back(deviceOrientation);
+                    }
+                    if (deviceOrientationTypeError && deviceOrientation.deviceIdx >= 0) {
+                        // Only an error for listed devices, which aren't known yet
+                        firstMistypedDeviceIdx = std::min(firstMistypedDeviceIdx, deviceOrientation.deviceIdx);
+                    }
+                }
+                break;
+            case FieldSamples:
+                if (depth == 3) {
+                    if (sampleFieldCount < 3) {
+                        return false;
+                    }
+                    // Samples with an unusable orientation are skipped, the rest of the batch still counts
+                    if (!invalidValues && parseOrientation(values, valueCount, sample.orientation)) {
+                        response.samples.push_back(sample);
+                    }
+                }
+                break;
+            case FieldOrientation:
+                if (depth == 2) {
+                    if (invalidValues && (valueCount == 3 || valueCount == 4)) {
+                        return false;
+                    }
+                    response.hasOrientation = !invalidValues && parseOrientation(values, valueCount, response.orientation);
+                }
+                break;
+            default:
+                break;
+        }
+        return leave();
+    }
+
+    bool key(string_t& name) {
+        if (depth != 1) {
+            return true;
+        }
+        field = FieldUnknown;
+        if (name == "devices") field = FieldDevices;
+        else if (name == "currentDeviceIdx") field = FieldCurrentDeviceIdx;
+        else if (name == "trackingEnabled") field = FieldTrackingEnabled;
+        else if (name == "trackingInverted") field = FieldTrackingInverted;
+        else if (name == "orientation") field = FieldOrientation;
+        else if (name == "timestampMicros") field = FieldTimestampMicros;
+        else if (name == "sequence") field = FieldSequence;
+        else if (name == "deviceOrientations") {
+            field = FieldDeviceOrientations;
+            response.hasDeviceOrientations = true;
+        }
+        else if (name == "samples") {
+            field = FieldSamples;
+            response.hasSamples = true;
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) {
+        return false;
+    }
+
+    // Checks the fields that have to be present once the whole body was read
+    bool finish() {
+        if (!hasCurrentDeviceIdx || trackingEnabledCount < 3 || trackingInvertedCount < 3) {
+            return false;
+        }
+        // Keys can arrive in any order, so the device indices are checked last
+        int deviceCount = (int)response.devices.size();
+        if (firstMistypedDeviceIdx < deviceCount) {
+            return false;
+        }
+        auto& deviceOrientations = response.deviceOrientations;
+        deviceOrientations.erase(std::remove_if(deviceOrientations.begin(), deviceOrientations.end(), [deviceCount](const M1OrientationPingResponse::DeviceOrientation& entry) {
+            return entry.deviceIdx < 0 || entry.deviceIdx >= deviceCount;
+        }), deviceOrientations.end());
+        return true;
+    }
+
+private:
+    enum Field {
+        FieldUnknown,
+        FieldDevices,
+        FieldCurrentDeviceIdx,
+        FieldTrackingEnabled,
+        FieldTrackingInverted,
+        FieldOrientation,
+        FieldTimestampMicros,
+        FieldSequence,
+        FieldDeviceOrientations,
+        FieldSamples,
+    };
+
+    enum ValueType {
+        ValueNull,
+        ValueBoolean,
+        ValueNumber,
+        ValueString,
+        ValueOther,
+    };
+
+    static const int MAX_TRACKED_DEPTH = 8;
+
+    M1OrientationPingResponse& response;
+    Field field = FieldUnknown;
+    int depth = 0; // number of open containers, the body object is 1
+    int elementCounts[MAX_TRACKED_DEPTH + 1] = {}; // elements seen so far per open container
+
+    bool booleanValue = false;
+    double numberValue = 0;
+    int64_t integerValue = 0;
+    string_t* stringValue = nullptr;
+
+    bool hasCurrentDeviceIdx = false;
+    int trackingEnabledCount = 0;
+    int trackingInvertedCount = 0;
+
+    // device entry being read: [name, type, address, hasStrength, strength]
+    int deviceFieldCount = 0;
+    M1OrientationStringTable::Ref deviceNameId;
+    M1OrientationStringTable::Ref deviceAddressId;
+    int deviceType = 0;
+    bool deviceHasStrength = false;
+    int deviceStrength = 0;
+
+    // orientation values being read
+    float values[4] = {};
+    int valueCount = 0;
+    bool invalidValues = false;
+
+    M1OrientationPingResponse::DeviceOrientation deviceOrientation;
+    int deviceOrientationFieldCount = 0;
+    bool deviceOrientationValid = false;
+    bool deviceOrientationTypeError = false;
+    int firstMistypedDeviceIdx = INT_MAX;
+
+    M1OrientationPingResponse::Sample sample;
+    int sampleFieldCount = 0;
+
+    int nextPosition() {
+        return depth <= MAX_TRACKED_DEPTH ? elementCounts[depth]++ : 0;
+    }
+
+    bool enter() {
+        depth++;
+        if (depth <= MAX_TRACKED_DEPTH) {
+            elementCounts[depth] = 0;
+        }
+        return true;
+    }
+
+    bool leave() {
+        depth--;
+        if (depth == 1) {
+            field = FieldUnknown;
+        }
+        return true;
+    }
+
+    // The device at the same position in the previous poll usually has the same strings, taking
+    // them from there keeps steady-state polls off the string table's lock
+    M1OrientationStringTable::Ref internDeviceString(const string_t& text, bool isName) {
+        std::size_t index = response.devices.size();
+        if (index < response.previousDevices.size()) {
+            const M1OrientationDeviceInfo& previous = response.previousDevices[index];
+            const M1OrientationStringTable::Ref& string = isName ? previous.getDeviceNameRef() : previous.getDeviceAddressRef();
+            if (M1OrientationStringTable::get(string.get()) == text) {
+                return string;
+            }
+        }
+        return M1OrientationStringTable::Ref::adopt(M1OrientationStringTable::intern(text));
+    }
+
+    // Like nlohmann's arithmetic conversions, booleans read as 0 / 1
+    static bool isNumeric(ValueType type) {
+        return type == ValueNumber || type == ValueBoolean;
+    }
+
+    bool isOrientationValue() const {
+        return (field == FieldOrientation && depth >= 2) || ((field == FieldDeviceOrientations || field == FieldSamples) && depth >= 4);
+    }
+
+    void addValue() {
+        if (valueCount < 4) {
+            values[valueCount] = (float)numberValue;
+        }
+        valueCount++;
+    }
+
+    bool scalar(ValueType type) {
+        if (depth == 0) {
+            return false; // the body has to be an object
+        }
+        int position = depth >= 2 ? nextPosition() : 0;
+        switch (field) {
+            case FieldCurrentDeviceIdx:
+                if (depth != 1 || !isNumeric(type)) {
+                    return false;
+                }
+                response.currentDeviceIdx = (int)integerValue;
+                hasCurrentDeviceIdx = true;
+                break;
+            case FieldTimestampMicros:
+                if (depth != 1 || !isNumeric(type)) {
+                    return false;
+                }
+                response.hasTimestamp = true;
+                response.timestampMicros = integerValue;
+                break;
+            case FieldSequence:
+                if (depth != 1 || !isNumeric(type)) {
+                    return false;
+                }
+                response.sequence = (uint32_t)integerValue;
+                break;
+            case FieldTrackingEnabled:
+            case FieldTrackingInverted:
+                if (depth == 2 && position < 3) {
+                    if (type != ValueBoolean) {
+                        return false;
+                    }
+                    if (field == FieldTrackingEnabled) {
+                        response.trackingEnabled[position] = booleanValue;
+                        trackingEnabledCount++;
+                    } else {
+                        response.trackingInverted[position] = booleanValue;
+                        trackingInvertedCount++;
+                    }
+                } else if (depth == 1) {
+                    return false;
+                }
+                break;
+            case FieldOrientation:
+                if (depth == 2) {
+                    if (isNumeric(type)) {
+                        addValue();
+                    } else {
+                        valueCount++;
+                        invalidValues = true;
+                    }
+                }
+                // anything else than an array is "no orientation"
+                break;
+            case FieldDevices:
+                if (depth == 1) {
+                    return type == ValueNull;
+                }
+                if (depth != 3) {
+                    return false;
+                }
+                deviceFieldCount++;
+                if (position == 0 || position == 2) {
+                    if (type != ValueString) {
+                        return false;
+                    }
+                    (position == 0 ? deviceNameId : deviceAddressId) = internDeviceString(*stringValue, position == 0);
+                } else if (position == 1 || position == 4) {
+                    if (!isNumeric(type)) {
+                        return false;
+                    }
+                    (position == 1 ? deviceType : deviceStrength) = (int)integerValue;
+                } else if (position == 3) {
+                    if (type != ValueBoolean) {
+                        return false;
+                    }
+                    deviceHasStrength = booleanValue;
+                }
+                break;
+            case FieldSamples:
+                if (depth == 1) {
+                    return type == ValueNull;
+                }
+                if (depth == 3) {
+                    sampleFieldCount++;
+                    if (position == 0 || position == 1) {
+                        if (!isNumeric(type)) {
+                            return false;
+                        }
+                        if (position == 0) {
+                            sample.sequence = (uint32_t)integerValue;
+                        } else {
+                            sample.timestampMicros = integerValue;
+                        }
+                    }
+                } else if (depth == 4) {
+                    if (isNumeric(type)) {
+                        addValue();
+                    } else {
+                        valueCount++;
+                        invalidValues = true;
+                    }
+                } else {
+                    return false;
+                }
+                break;
+            case FieldDeviceOrientations:
+                if (depth == 1) {
+                    return type == ValueNull;
+                }
+                if (depth == 3) {
+                    deviceOrientationFieldCount++;
+                    if (position == 0 || position == 2) {
+                        if (!isNumeric(type)) {
+                            return false;
+                        }
+                        if (position == 0) {
+                            deviceOrientation.deviceIdx = (int)integerValue;
+                        } else {
+                            deviceOrientation.hasTimestamp = true;
+                            deviceOrientation.timestampMicros = integerValue;
+                        }
+                    } else if (position == 1) {
+                        deviceOrientationValid = false; // not an array
+                    }
+                } else if (depth == 4) {
+                    if (isNumeric(type)) {
+                        addValue();
+                    } else {
+                        valueCount++;
+                        invalidValues = true;
+                    }
+                } else {
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+};
+
+}
+
+bool M1OrientationPingResponse::parse(const std::string& body) {
+    // Reset in place so the vectors keep their capacity from the previous poll
+    previousDevices.swap(devices);
+    devices.clear();
+    currentDeviceIdx = -1;
+    hasOrientation = false;
+    hasTimestamp = false;
+    timestampMicros = 0;
+    sequence = 0;
+    hasDeviceOrientations = false;
+    deviceOrientations.clear();
+    hasSamples = false;
+    samples.clear();
+
+    try {
+        PingResponseSaxHandler handler(*this);
+        return nlohmann::json::sax_parse(body, &handler) && handler.finish();
+    } catch (const nlohmann::json::exception&) {
+        return false;
+    }
+}
+
+M1OrientationDeviceInfo M1OrientationPingResponse::getCurrentDevice() const {
+    if (currentDeviceIdx >= 0 && currentDeviceIdx < (int)devices.size()) {
+        return devices[currentDeviceIdx];
+    }
+    return M1OrientationDeviceInfo();
+}
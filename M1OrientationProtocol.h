@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "M1OrientationTypes.h"
+
+#ifndef PI
+#define PI       3.14159265358979323846
+#endif
+
+// Orientation array as received, 3 (euler) or 4 (quaternion) values in the sending device's
+// convention. Converted once at ingest by the device's M1OrientationConventionAdapter.
+struct M1OrientationRawSample {
+    float values[4] = {};
+    int count = 0;
+};
+
+// Decoded body of the orientation server's /ping response. Kept free of JUCE so the
+// parsing can be benchmarked and reused by tools outside of a plugin.
+struct M1OrientationPingResponse {
+    struct DeviceOrientation {
+        int deviceIdx = -1;
+        M1OrientationRawSample orientation;
+        bool hasTimestamp = false;
+        int64_t timestampMicros = 0; // capture time reported by the server
+    };
+
+    // One sensor sample of the current device, servers that batch send every sample since the
+    // sequence acknowledged in the request (`/ping?since=<sequence>`)
+    struct Sample {
+        uint32_t sequence = 0;
+        int64_t timestampMicros = 0;
+        M1OrientationRawSample orientation;
+    };
+
+    std::vector<M1OrientationDeviceInfo> devices;
+    std::vector<M1OrientationDeviceInfo> previousDevices; // of the previous parse, unchanged devices reuse their interned strings
+    int currentDeviceIdx = -1;
+    bool trackingEnabled[3] = { true, true, true }; // yaw, pitch, roll
+    bool trackingInverted[3] = { false, false, false };
+    bool hasOrientation = false;
+    M1OrientationRawSample orientation; // of the current device
+    bool hasTimestamp = false;
+    int64_t timestampMicros = 0; // optional steady clock capture time of `orientation`
+    uint32_t sequence = 0; // optional, increments per new sample on servers that report it
+    bool hasDeviceOrientations = false; // server supports multiple device streams
+    std::vector<DeviceOrientation> deviceOrientations;
+    bool hasSamples = false; // server supports batched samples
+    std::vector<Sample> samples; // oldest first, the last one is also sent as `orientation`
+
+    // Returns false for malformed bodies instead of throwing on the polling thread
+    bool parse(const std::string& body);
+
+    M1OrientationDeviceInfo getCurrentDevice() const;
+};
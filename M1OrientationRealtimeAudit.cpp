@@ -0,0 +1,138 @@
+#include "M1OrientationRealtimeAudit.h"
+
+#if M1_ORIENTATION_RT_AUDIT
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+std::atomic<bool> M1OrientationRealtimeAudit::trapEnabled { false };
+std::atomic<uint64_t> M1OrientationRealtimeAudit::counts[ViolationCount] = {};
+std::atomic<const char*> M1OrientationRealtimeAudit::lastApi { nullptr };
+std::atomic<int> M1OrientationRealtimeAudit::lastViolation { ViolationCount };
+
+// Plain thread_locals only, reporting runs inside operator new and must not allocate itself
+static thread_local bool threadRealtime = false;
+static thread_local const char* threadApi = nullptr;
+static thread_local bool threadReporting = false;
+
+bool M1OrientationRealtimeAudit::setThreadRealtime(bool realtime) {
+    bool previous = threadRealtime;
+    threadRealtime = realtime;
+    return previous;
+}
+
+bool M1OrientationRealtimeAudit::isThreadRealtime() {
+    return threadRealtime;
+}
+
+M1OrientationRealtimeAudit::ApiScope::ApiScope(const char* name) : previous(threadApi) {
+    if (threadApi == nullptr) {
+        threadApi = name;
+    }
+}
+
+M1OrientationRealtimeAudit::ApiScope::~ApiScope() {
+    threadApi = previous;
+}
+
+void M1OrientationRealtimeAudit::setTrapEnabled(bool trap) {
+    trapEnabled.store(trap, std::memory_order_relaxed);
+}
+
+void M1OrientationRealtimeAudit::report(Violation violation) {
+    if (!threadRealtime || threadApi == nullptr || threadReporting) {
+        return;
+    }
+    threadReporting = true;
+    counts[violation].fetch_add(1, std::memory_order_relaxed);
+    lastApi.store(threadApi, std::memory_order_relaxed);
+    lastViolation.store(violation, std::memory_order_relaxed);
+    if (trapEnabled.load(std::memory_order_relaxed)) {
+        static const char* const names[ViolationCount] = { "allocation", "lock", "syscall" };
+        std::fprintf(stderr, "[M1OrientationRealtimeAudit] %s in %s on a real-time thread\n", names[violation], threadApi);
+        std::abort();
+    }
+    threadReporting = false;
+}
+
+M1OrientationRealtimeAudit::Counts M1OrientationRealtimeAudit::getCounts() {
+    Counts result;
+    result.allocations = counts[Allocation].load(std::memory_order_relaxed);
+    result.locks = counts[Lock].load(std::memory_order_relaxed);
+    result.syscalls = counts[Syscall].load(std::memory_order_relaxed);
+    result.lastApi = lastApi.load(std::memory_order_relaxed);
+    result.lastViolation = (Violation)lastViolation.load(std::memory_order_relaxed);
+    return result;
+}
+
+void M1OrientationRealtimeAudit::reset() {
+    for (auto& count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    lastApi.store(nullptr, std::memory_order_relaxed);
+    lastViolation.store(ViolationCount, std::memory_order_relaxed);
+}
+
+// Replacement global allocation functions, frees count as well since they can take the allocator's lock.
+// The aligned overloads are left to the runtime.
+
+static void* auditedAllocate(std::size_t size) {
+    M1OrientationRealtimeAudit::report(M1OrientationRealtimeAudit::Allocation);
+    void* memory = std::malloc(size != 0 ? size : 1);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+static void auditedFree(void* memory) {
+    if (memory != nullptr) {
+        M1OrientationRealtimeAudit::report(M1OrientationRealtimeAudit::Allocation);
+        std::free(memory);
+    }
+}
+
+void* operator new(std::size_t size) {
+    return auditedAllocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return auditedAllocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    M1OrientationRealtimeAudit::report(M1OrientationRealtimeAudit::Allocation);
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    M1OrientationRealtimeAudit::report(M1OrientationRealtimeAudit::Allocation);
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void operator delete(void* memory) noexcept {
+    auditedFree(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    auditedFree(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    auditedFree(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    auditedFree(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    auditedFree(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    auditedFree(memory);
+}
+
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+// Optional real-time safety audit of the client API.
+// Compiled out entirely unless M1_ORIENTATION_RT_AUDIT is set to 1. A thread that calls the client
+// from an audio callback marks itself with M1OrientationRealtimeAudit::ScopedRealtimeThread, and every
+// heap allocation or free, client mutex lock and blocking system call (network, file, thread, sleep)
+// made inside a client API on that thread is counted, or trapped when trapping is enabled.
+//
+// Allocations are seen through replacement global operator new/delete (M1OrientationRealtimeAudit.cpp),
+// so only enable this in debug and test builds. Work done by the host itself on a marked thread is
+// not counted, only work inside client APIs.
+//
+// The real-time safe subset, expected to report nothing once the client has been running, with or
+// without M1_ORIENTATION_TRACING (checked by tests/M1OrientationRealtimeAuditTest.cpp):
+// getOrientation(), getRawOrientation(), getOrientationHistory(), getOrientationAt(), rotateDirections(), getDeviceOrientation(), getFusedOrientation(), isFusionActive(), getTracking*(),
+// getStateGeneration(), getOrientationVersion(), getDeviceStreamsFrame(), hasReceivedFirstSample(),
+// isConnectedToServer(), isConnectedToDevice(), getCurrentDeviceType(), isRecording(), isReplaying().
+// With setSampleAgeAtReadEnabled(true), getOrientation() and rotateDirections() also update a
+// shared histogram with atomic read-modify-writes; lock-free but contended, leave it off in production.
+
+#ifndef M1_ORIENTATION_RT_AUDIT
+#define M1_ORIENTATION_RT_AUDIT 0
+#endif
+
+#include <condition_variable>
+#include <mutex>
+
+#if M1_ORIENTATION_RT_AUDIT
+
+#include <atomic>
+#include <cstdint>
+
+class M1OrientationRealtimeAudit
+{
+public:
+    enum Violation {
+        Allocation = 0,
+        Lock,
+        Syscall,
+        ViolationCount
+    };
+
+    struct Counts {
+        uint64_t allocations = 0;
+        uint64_t locks = 0;
+        uint64_t syscalls = 0;
+        const char* lastApi = nullptr; // client API of the most recent violation
+        Violation lastViolation = ViolationCount;
+
+        uint64_t total() const {
+            return allocations + locks + syscalls;
+        }
+    };
+
+    // Marks the calling thread as real-time for its lifetime, e.g. at the top of processBlock()
+    class ScopedRealtimeThread {
+        bool previous;
+    public:
+        ScopedRealtimeThread() : previous(setThreadRealtime(true)) {}
+        ~ScopedRealtimeThread() {
+            setThreadRealtime(previous);
+        }
+    };
+
+    // Placed at the top of client APIs (M1_ORIENTATION_RT_API), violations are attributed to the outermost one
+    class ApiScope {
+        const char* previous;
+    public:
+        explicit ApiScope(const char* name);
+        ~ApiScope();
+    };
+
+    static bool setThreadRealtime(bool realtime); // returns the previous state
+    static bool isThreadRealtime();
+
+    // Aborts with the API name on the first violation, for catching the call site in a debugger
+    static void setTrapEnabled(bool trap);
+
+    // Counts `violation` if the calling thread is real-time and inside a client API
+    static void report(Violation violation);
+
+    static Counts getCounts();
+    static void reset();
+
+private:
+    static std::atomic<bool> trapEnabled;
+    static std::atomic<uint64_t> counts[ViolationCount];
+    static std::atomic<const char*> lastApi;
+    static std::atomic<int> lastViolation;
+};
+
+// Client state mutex, reports a Lock when taken inside an API on a real-time thread
+class M1OrientationMutex
+{
+    std::mutex mutex;
+public:
+    void lock() {
+        M1OrientationRealtimeAudit::report(M1OrientationRealtimeAudit::Lock);
+        mutex.lock();
+    }
+    bool try_lock() {
+        M1OrientationRealtimeAudit::report(M1OrientationRealtimeAudit::Lock);
+        return mutex.try_lock();
+    }
+    void unlock() {
+        mutex.unlock();
+    }
+};
+typedef std::condition_variable_any M1OrientationConditionVariable;
+
+#define M1_ORIENTATION_RT_AUDIT_CONCAT_INNER(a, b) a##b
+#define M1_ORIENTATION_RT_AUDIT_CONCAT(a, b) M1_ORIENTATION_RT_AUDIT_CONCAT_INNER(a, b)
+#define M1_ORIENTATION_RT_API(name) M1OrientationRealtimeAudit::ApiScope M1_ORIENTATION_RT_AUDIT_CONCAT(m1OrientationRtApi, __LINE__)(name)
+#define M1_ORIENTATION_RT_SYSCALL() M1OrientationRealtimeAudit::report(M1OrientationRealtimeAudit::Syscall)
+
+#else
+
+typedef std::mutex M1OrientationMutex;
+typedef std::condition_variable M1OrientationConditionVariable;
+
+#define M1_ORIENTATION_RT_API(name)
+#define M1_ORIENTATION_RT_SYSCALL()
+
+#endif
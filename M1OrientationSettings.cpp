@@ -1,9 +1,86 @@
 #include <JuceHeader.h>
 #include "M1OrientationSettings.h"
 
-bool M1OrientationManagerOSCSettings::initFromSettings(std::string jsonSettingsFilePath) {
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#if JUCE_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+std::string M1OrientationManagerOSCSettings::getDefaultSettingsFilePath() {
+    // Using `currentApplicationFile` to be safe for both plugins and apps on all OS targets
+    //juce::File pluginExe = juce::File::getSpecialLocation(juce::File::currentApplicationFile);
+    //juce::File appDirectory = pluginExe.getParentDirectory();
+    
+    // Using common support files installation location
+    juce::File m1SupportDirectory = juce::File::getSpecialLocation(juce::File::commonApplicationDataDirectory);
+    
+    juce::File settingsFile;
+    if ((juce::SystemStats::getOperatingSystemType() & juce::SystemStats::MacOSX) != 0) {
+        // test for any mac OS
+        settingsFile = m1SupportDirectory.getChildFile("Application Support").getChildFile("Mach1");
+    } else if ((juce::SystemStats::getOperatingSystemType() & juce::SystemStats::Windows) != 0) {
+        // test for any windows OS
+        settingsFile = m1SupportDirectory.getChildFile("Mach1");
+    } else {
+        settingsFile = m1SupportDirectory.getChildFile("Mach1");
+    }
+    settingsFile = settingsFile.getChildFile("settings.json");
+    return settingsFile.getFullPathName().toStdString();
+}
+
+std::string M1OrientationManagerOSCSettings::getCanonicalSettingsFilePath(const std::string& jsonSettingsFilePath) {
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::weakly_canonical(std::filesystem::absolute(jsonSettingsFilePath, error), error);
+    if (error) {
+        return jsonSettingsFilePath;
+    }
+    return path.string();
+}
+
+bool M1OrientationManagerOSCSettings::loadSettings(std::string jsonSettingsFilePath, M1OrientationSettingsData& settings, bool forceReload) {
+    // Every client in the process shares this cache so the file is only parsed once per version,
+    // an entry is reused only while the file's modification time and size still match it
+    struct CachedSettings {
+        M1OrientationSettingsData settings;
+        juce::int64 modifiedMillis = 0;
+        juce::int64 size = 0;
+    };
+    static std::mutex cacheMutex;
+    static std::map<std::string, CachedSettings> cache;
+
+    jsonSettingsFilePath = getCanonicalSettingsFilePath(jsonSettingsFilePath);
     juce::File settingsFile = juce::File(jsonSettingsFilePath);
     if (!settingsFile.exists()) {
+        return false;
+    }
+    juce::int64 modifiedMillis = settingsFile.getLastModificationTime().toMilliseconds();
+    juce::int64 size = settingsFile.getSize();
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto cached = cache.find(jsonSettingsFilePath);
+    if (cached != cache.end() && !forceReload && cached->second.modifiedMillis == modifiedMillis && cached->second.size == size) {
+        settings = cached->second.settings;
+        return true;
+    }
+
+    DBG("Opening settings file: " + settingsFile.getFullPathName().quoted());
+    juce::var mainVar = juce::JSON::parse(settingsFile);
+    settings.serverPort = mainVar["serverPort"];
+    settings.helperPort = mainVar["helperPort"];
+    cache[jsonSettingsFilePath] = { settings, modifiedMillis, size };
+    return true;
+}
+
+bool M1OrientationManagerOSCSettings::initFromSettings(std::string jsonSettingsFilePath) {
+    M1OrientationSettingsData settings;
+    if (!loadSettings(jsonSettingsFilePath, settings)) {
         // Hiding UI error by default
         // TODO: handle this more elegantly
 //            juce::AlertWindow::showMessageBoxAsync(
@@ -20,11 +97,7 @@ bool M1OrientationManagerOSCSettings::initFromSettings(std::string jsonSettingsF
     }
     else {
         // Found the settings.json
-        juce::var mainVar = juce::JSON::parse(juce::File(jsonSettingsFilePath));
-        int serverPort = mainVar["serverPort"];
-        int helperPort = mainVar["helperPort"];
-
-        if (!init(serverPort, helperPort)) {
+        if (!init(settings.serverPort, settings.helperPort)) {
             juce::AlertWindow::showMessageBoxAsync(
                 juce::AlertWindow::WarningIcon,
                 "Warning",
@@ -40,3 +113,138 @@ bool M1OrientationManagerOSCSettings::initFromSettings(std::string jsonSettingsF
     }
     return true;
 }
+
+// One watching thread per settings file, shared by every M1OrientationSettingsWatcher of that file
+struct M1OrientationSettingsWatcher::SharedWatch {
+    std::string settingsFilePath;
+    std::thread watcherThread;
+    std::atomic<bool> isWatching { true };
+    M1OrientationSettingsData lastSettings; // watcher thread only
+    std::map<M1OrientationSettingsWatcher*, std::function<void(M1OrientationSettingsData settings)>> callbacks; // guarded by `getSharedWatchMutex()`
+
+    void run();
+    void reload();
+};
+
+static std::mutex& getSharedWatchMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::map<std::string, std::weak_ptr<M1OrientationSettingsWatcher::SharedWatch>>& getSharedWatches() {
+    static std::map<std::string, std::weak_ptr<M1OrientationSettingsWatcher::SharedWatch>> watches; // guarded by `getSharedWatchMutex()`
+    return watches;
+}
+
+M1OrientationSettingsWatcher::~M1OrientationSettingsWatcher() {
+    stop();
+}
+
+void M1OrientationSettingsWatcher::SharedWatch::reload() {
+    M1OrientationSettingsData settings;
+    if (!M1OrientationManagerOSCSettings::loadSettings(settingsFilePath, settings, true)) {
+        return; // file is mid-replace or was removed, keep the last known ports
+    }
+    if (settings != lastSettings) {
+        DBG("[M1OrientationSettingsWatcher] Ports changed to server: " + std::to_string(settings.serverPort) + " helper: " + std::to_string(settings.helperPort));
+        lastSettings = settings;
+        // Called under the lock so stop() returning means its callback won't run again
+        std::lock_guard<std::mutex> lock(getSharedWatchMutex());
+        for (auto& callback : callbacks) {
+            callback.second(settings);
+        }
+    }
+}
+
+void M1OrientationSettingsWatcher::start(std::string jsonSettingsFilePath, std::function<void(M1OrientationSettingsData settings)> callback) {
+    stop();
+
+    std::string settingsFilePath = M1OrientationManagerOSCSettings::getCanonicalSettingsFilePath(jsonSettingsFilePath);
+    std::lock_guard<std::mutex> lock(getSharedWatchMutex());
+    auto& sharedWatch = getSharedWatches()[settingsFilePath];
+    watch = sharedWatch.lock();
+    if (!watch) {
+        watch = std::make_shared<SharedWatch>();
+        watch->settingsFilePath = settingsFilePath;
+        // Read from disk rather than the cache, the file may have been edited while nothing watched it
+        M1OrientationManagerOSCSettings::loadSettings(settingsFilePath, watch->lastSettings, true);
+        watch->watcherThread = std::thread(&SharedWatch::run, watch.get());
+        sharedWatch = watch;
+    }
+    watch->callbacks[this] = callback;
+}
+
+void M1OrientationSettingsWatcher::stop() {
+    if (!watch) {
+        return;
+    }
+    std::shared_ptr<SharedWatch> stopping;
+    {
+        std::lock_guard<std::mutex> lock(getSharedWatchMutex());
+        watch->callbacks.erase(this);
+        if (watch->callbacks.empty()) {
+            // Last watcher of this file, the thread goes with it
+            getSharedWatches().erase(watch->settingsFilePath);
+            stopping = watch;
+        }
+        watch.reset();
+    }
+    if (stopping) {
+        stopping->isWatching = false;
+        if (stopping->watcherThread.joinable()) {
+            stopping->watcherThread.join();
+        }
+    }
+}
+
+void M1OrientationSettingsWatcher::SharedWatch::run() {
+#if JUCE_LINUX
+    // Watching the directory rather than the file so editors that save by rename are caught too
+    juce::File settingsFile(settingsFilePath);
+    std::string directory = settingsFile.getParentDirectory().getFullPathName().toStdString();
+    std::string fileName = settingsFile.getFileName().toStdString();
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    int wd = fd >= 0 ? inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) : -1;
+    if (wd >= 0) {
+        alignas(struct inotify_event) char buffer[4096];
+        while (isWatching) {
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 250) <= 0) {
+                continue;
+            }
+
+            bool changed = false;
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* ptr = buffer; ptr < buffer + length; ) {
+                    auto* event = reinterpret_cast<struct inotify_event*>(ptr);
+                    if (event->len > 0 && fileName == event->name) {
+                        changed = true;
+                    }
+                    ptr += sizeof(struct inotify_event) + event->len;
+                }
+            }
+            if (changed) {
+                reload();
+            }
+        }
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (wd >= 0) {
+        return;
+    }
+    // inotify unavailable, fall through to polling
+#endif
+    juce::int64 lastModified = juce::File(settingsFilePath).getLastModificationTime().toMilliseconds();
+    while (isWatching) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        juce::int64 modified = juce::File(settingsFilePath).getLastModificationTime().toMilliseconds();
+        if (modified != lastModified) {
+            lastModified = modified;
+            reload();
+        }
+    }
+}
@@ -1,10 +1,52 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
 
+struct M1OrientationSettingsData {
+    int serverPort = 0;
+    int helperPort = 0;
+
+    bool operator==(const M1OrientationSettingsData& rhs) const {
+        return serverPort == rhs.serverPort && helperPort == rhs.helperPort;
+    }
+
+    bool operator!=(const M1OrientationSettingsData& rhs) const {
+        return !(*this == rhs);
+    }
+};
+
 class M1OrientationManagerOSCSettings
 {
 public:
     virtual bool init(int serverPort, int helperPort) = 0;
     bool initFromSettings(std::string jsonSettingsFilePath);
+
+    // Location of Mach1's settings.json in the common support files directory
+    static std::string getDefaultSettingsFilePath();
+    // Absolute path with symlinks and `..` resolved, so different spellings of a path share a cache entry and watcher
+    static std::string getCanonicalSettingsFilePath(const std::string& jsonSettingsFilePath);
+
+    // Parses the settings file once per process and returns the cached result until the file's
+    // modification time or size changes, `forceReload` is used by the watcher when the file changed on disk
+    static bool loadSettings(std::string jsonSettingsFilePath, M1OrientationSettingsData& settings, bool forceReload = false);
+};
+
+// Watches a settings.json for edits (inotify on Linux, modification time polling elsewhere)
+// and reports the reloaded settings whenever the ports change. Watchers of the same file share
+// one watching thread per process, however many clients are started.
+class M1OrientationSettingsWatcher
+{
+public:
+    struct SharedWatch;
+
+private:
+    std::shared_ptr<SharedWatch> watch;
+
+public:
+    ~M1OrientationSettingsWatcher();
+
+    void start(std::string jsonSettingsFilePath, std::function<void(M1OrientationSettingsData settings)> callback);
+    void stop();
 };
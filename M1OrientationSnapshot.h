@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single writer, many readers value published without locks (seqlock).
+// The polling thread publishes and any thread, including the audio thread, can read:
+// readers never block the writer and only retry if they overlapped a publish.
+template <typename T>
+class M1OrientationSnapshot
+{
+    static_assert(std::is_trivially_copyable<T>::value, "M1OrientationSnapshot copies its value without locks");
+
+    std::atomic<uint32_t> sequence { 0 };
+    T value {};
+
+public:
+    void publish(const T& newValue) {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed); // odd while writing
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy((void*)&value, (const void*)&newValue, sizeof(T));
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    T read() const {
+        T result;
+        uint32_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            std::memcpy((void*)&result, (const void*)&value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return result;
+    }
+
+    // Number of publishes so far, lets readers skip work when nothing changed
+    uint32_t getVersion() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+};
@@ -0,0 +1,158 @@
+#include "M1OrientationStats.h"
+
+int M1OrientationLatencyHistogram::getBucketIndex(uint64_t value) {
+    if (value < (uint64_t)SUB_BUCKETS) {
+        return (int)value;
+    }
+    int highestBit = 0;
+    while (value >> (highestBit + 1)) {
+        highestBit++;
+    }
+    int magnitude = highestBit - SUB_BUCKET_BITS + 1;
+    int subBucket = (int)((value >> (highestBit - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    int index = magnitude * SUB_BUCKETS + subBucket;
+    return index < BUCKETS ? index : BUCKETS - 1;
+}
+
+int64_t M1OrientationLatencyHistogram::getBucketUpperBound(int index) {
+    int magnitude = index / SUB_BUCKETS;
+    int subBucket = index % SUB_BUCKETS;
+    if (magnitude == 0) {
+        return subBucket;
+    }
+    int64_t start = (int64_t)(SUB_BUCKETS + subBucket) << (magnitude - 1);
+    return start + ((int64_t)1 << (magnitude - 1)) - 1;
+}
+
+void M1OrientationLatencyHistogram::record(int64_t valueMicros) {
+    if (valueMicros < 0) {
+        valueMicros = 0;
+    }
+    counts[getBucketIndex((uint64_t)valueMicros)].fetch_add(1, std::memory_order_relaxed);
+    totalCount.fetch_add(1, std::memory_order_relaxed);
+    sumMicros.fetch_add(valueMicros, std::memory_order_relaxed);
+
+    int64_t currentMin = minMicros.load(std::memory_order_relaxed);
+    while (valueMicros < currentMin && !minMicros.compare_exchange_weak(currentMin, valueMicros, std::memory_order_relaxed)) {}
+    int64_t currentMax = maxMicros.load(std::memory_order_relaxed);
+    while (valueMicros > currentMax && !maxMicros.compare_exchange_weak(currentMax, valueMicros, std::memory_order_relaxed)) {}
+}
+
+int64_t M1OrientationLatencyHistogram::getPercentile(double percentile) const {
+    uint64_t total = totalCount.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(percentile / 100.0 * total + 0.5);
+    if (target < 1) target = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            int64_t upperBound = getBucketUpperBound(i);
+            int64_t max = maxMicros.load(std::memory_order_relaxed);
+            return upperBound < max ? upperBound : max;
+        }
+    }
+    return maxMicros.load(std::memory_order_relaxed);
+}
+
+M1OrientationLatencyHistogram::Summary M1OrientationLatencyHistogram::getSummary() const {
+    Summary summary;
+    summary.count = totalCount.load(std::memory_order_relaxed);
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.minMicros = minMicros.load(std::memory_order_relaxed);
+    summary.maxMicros = maxMicros.load(std::memory_order_relaxed);
+    summary.meanMicros = (double)sumMicros.load(std::memory_order_relaxed) / summary.count;
+    summary.p50Micros = getPercentile(50);
+    summary.p90Micros = getPercentile(90);
+    summary.p99Micros = getPercentile(99);
+    summary.p999Micros = getPercentile(99.9);
+    return summary;
+}
+
+void M1OrientationLatencyHistogram::reset() {
+    for (int i = 0; i < BUCKETS; i++) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+    totalCount.store(0, std::memory_order_relaxed);
+    sumMicros.store(0, std::memory_order_relaxed);
+    minMicros.store(INT64_MAX, std::memory_order_relaxed);
+    maxMicros.store(0, std::memory_order_relaxed);
+}
+
+void M1OrientationStats::recordSampleReceived(int64_t receivedMicros) {
+    samplesReceived.fetch_add(1, std::memory_order_relaxed);
+    lastSampleReceivedMicros.store(receivedMicros, std::memory_order_relaxed);
+}
+
+void M1OrientationStats::recordSampleRead() {
+    if (!sampleAgeAtReadEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    int64_t received = lastSampleReceivedMicros.load(std::memory_order_relaxed);
+    if (received != 0) {
+        sampleAgeAtRead.record(nowMicros() - received);
+    }
+}
+
+void M1OrientationStats::setSampleAgeAtReadEnabled(bool enable) {
+    sampleAgeAtReadEnabled.store(enable, std::memory_order_relaxed);
+}
+
+void M1OrientationStats::updateRate() {
+    int64_t now = nowMicros();
+    if (rateWindowStartMicros == 0) {
+        rateWindowStartMicros = now;
+        rateWindowSamples = samplesReceived.load(std::memory_order_relaxed);
+        return;
+    }
+    int64_t elapsed = now - rateWindowStartMicros;
+    if (elapsed >= 1000000) {
+        uint64_t samples = samplesReceived.load(std::memory_order_relaxed);
+        if (samples < rateWindowSamples) {
+            rateWindowSamples = 0; // counters were reset
+        }
+        updatesPerSecond.store((samples - rateWindowSamples) * 1000000.0 / elapsed, std::memory_order_relaxed);
+        rateWindowSamples = samples;
+        rateWindowStartMicros = now;
+    }
+}
+
+M1OrientationClientStats M1OrientationStats::getStats() const {
+    M1OrientationClientStats stats;
+    stats.pingRoundTrip = pingRoundTrip.getSummary();
+    stats.parseDuration = parseDuration.getSummary();
+    stats.sampleAgeAtRead = sampleAgeAtRead.getSummary();
+    stats.commandLatency = commandLatency.getSummary();
+    stats.updatesPerSecond = updatesPerSecond.load(std::memory_order_relaxed);
+    stats.samplesReceived = samplesReceived.load(std::memory_order_relaxed);
+    stats.pingsSucceeded = pingsSucceeded.load(std::memory_order_relaxed);
+    stats.pingsFailed = pingsFailed.load(std::memory_order_relaxed);
+    stats.commandsSucceeded = commandsSucceeded.load(std::memory_order_relaxed);
+    stats.commandsFailed = commandsFailed.load(std::memory_order_relaxed);
+    stats.commandTimeouts = commandTimeouts.load(std::memory_order_relaxed);
+    stats.samplesRejected = samplesRejected.load(std::memory_order_relaxed);
+    stats.samplesRenormalized = samplesRenormalized.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void M1OrientationStats::reset() {
+    pingRoundTrip.reset();
+    parseDuration.reset();
+    sampleAgeAtRead.reset();
+    commandLatency.reset();
+    pingsSucceeded = 0;
+    pingsFailed = 0;
+    commandsSucceeded = 0;
+    commandsFailed = 0;
+    commandTimeouts = 0;
+    samplesRejected = 0;
+    samplesRenormalized = 0;
+    samplesReceived = 0;
+    lastSampleReceivedMicros = 0;
+    updatesPerSecond = 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Lock-free latency histogram with HDR-style log-linear buckets: values are grouped by power of
+// two and each power is split into SUB_BUCKETS linear steps, giving ~12% relative precision
+// from 1us up to hours in a fixed amount of memory. Safe to record from any thread.
+class M1OrientationLatencyHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAGNITUDES = 32;
+    static constexpr int BUCKETS = SUB_BUCKETS * MAGNITUDES;
+
+    struct Summary {
+        uint64_t count = 0;
+        int64_t minMicros = 0;
+        int64_t maxMicros = 0;
+        double meanMicros = 0;
+        int64_t p50Micros = 0;
+        int64_t p90Micros = 0;
+        int64_t p99Micros = 0;
+        int64_t p999Micros = 0;
+    };
+
+    M1OrientationLatencyHistogram() {
+        reset();
+    }
+
+    void record(int64_t valueMicros);
+    Summary getSummary() const;
+    int64_t getPercentile(double percentile) const;
+    void reset();
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS];
+    std::atomic<uint64_t> totalCount;
+    std::atomic<int64_t> sumMicros;
+    std::atomic<int64_t> minMicros;
+    std::atomic<int64_t> maxMicros;
+
+    static int getBucketIndex(uint64_t value);
+    static int64_t getBucketUpperBound(int index);
+};
+
+struct M1OrientationClientStats {
+    M1OrientationLatencyHistogram::Summary pingRoundTrip;
+    M1OrientationLatencyHistogram::Summary parseDuration;
+    M1OrientationLatencyHistogram::Summary sampleAgeAtRead; // time since the sample was received when getOrientation() returned it, opt-in
+    M1OrientationLatencyHistogram::Summary commandLatency;
+    double updatesPerSecond = 0;
+    uint64_t samplesReceived = 0;
+    uint64_t samplesRejected = 0; // NaN, infinity or not a rotation, the last good orientation was kept
+    uint64_t samplesRenormalized = 0;
+    uint64_t pingsSucceeded = 0;
+    uint64_t pingsFailed = 0;
+    uint64_t commandsSucceeded = 0;
+    uint64_t commandsFailed = 0;
+    uint64_t commandTimeouts = 0;
+};
+
+// Counters and histograms updated by the client, the snapshot is taken with getStats()
+class M1OrientationStats
+{
+public:
+    static int64_t nowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void recordSampleReceived(int64_t receivedMicros);
+    // Called from getOrientation(), a single relaxed load unless enabled. Recording shares cache lines
+    // with the polling thread, so it is off by default to keep it out of audio callbacks.
+    void recordSampleRead();
+    void setSampleAgeAtReadEnabled(bool enable);
+    void updateRate(); // called periodically from the polling thread
+    M1OrientationClientStats getStats() const;
+    void reset(); // the rate window belongs to the polling thread and restarts on its own
+
+    M1OrientationLatencyHistogram pingRoundTrip;
+    M1OrientationLatencyHistogram parseDuration;
+    M1OrientationLatencyHistogram sampleAgeAtRead;
+    M1OrientationLatencyHistogram commandLatency;
+    std::atomic<uint64_t> pingsSucceeded { 0 };
+    std::atomic<uint64_t> pingsFailed { 0 };
+    std::atomic<uint64_t> commandsSucceeded { 0 };
+    std::atomic<uint64_t> commandsFailed { 0 };
+    std::atomic<uint64_t> commandTimeouts { 0 };
+    std::atomic<uint64_t> samplesRejected { 0 };
+    std::atomic<uint64_t> samplesRenormalized { 0 };
+
+private:
+    std::atomic<uint64_t> samplesReceived { 0 };
+    std::atomic<int64_t> lastSampleReceivedMicros { 0 };
+    std::atomic<double> updatesPerSecond { 0 };
+    uint64_t rateWindowSamples = 0;
+    int64_t rateWindowStartMicros = 0;
+    alignas(64) std::atomic<bool> sampleAgeAtReadEnabled { false }; // read by every getOrientation(), kept off the counters' lines
+};
@@ -0,0 +1,161 @@
+#include "M1OrientationStringTable.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct StringTableEntry {
+    std::string text;
+    std::size_t hash = 0;
+    std::atomic<uint32_t> references { 0 };
+    bool live = false; // guarded by `mutex`, false while the id waits on the free list
+};
+
+// Entries live in fixed size chunks that are never moved, so readers can index them without
+// the lock while intern() appends
+const std::size_t STRING_TABLE_CHUNK_BITS = 10;
+const std::size_t STRING_TABLE_CHUNK_SIZE = 1 << STRING_TABLE_CHUNK_BITS;
+const std::size_t STRING_TABLE_MAX_CHUNKS = 4096;
+
+struct StringTableStorage {
+    std::shared_mutex mutex;
+    std::unordered_map<std::string_view, M1OrientationStringTable::Id> ids; // views into the live entries, guarded by `mutex`
+    std::vector<M1OrientationStringTable::Id> freeIds; // guarded by `mutex`
+    std::atomic<StringTableEntry*> chunks[STRING_TABLE_MAX_CHUNKS] = {};
+    std::atomic<std::size_t> count { 0 }; // ids handed out so far, freed ones included
+    std::atomic<std::size_t> liveCount { 0 };
+
+    StringTableStorage() {
+        append(std::string_view());
+    }
+
+    ~StringTableStorage() {
+        for (auto& chunk : chunks) {
+            delete[] chunk.load();
+        }
+    }
+
+    // Requires `mutex` held exclusively (or construction), returns the id with one reference
+    M1OrientationStringTable::Id append(std::string_view text) {
+        std::size_t index;
+        if (!freeIds.empty()) {
+            index = freeIds.back();
+            freeIds.pop_back();
+        } else {
+            index = count.load(std::memory_order_relaxed);
+            if (index >= STRING_TABLE_CHUNK_SIZE * STRING_TABLE_MAX_CHUNKS) {
+                // Out of ids, only possible with millions of strings in use at once
+                return M1OrientationStringTable::Empty;
+            }
+            if (chunks[index >> STRING_TABLE_CHUNK_BITS].load(std::memory_order_relaxed) == nullptr) {
+                chunks[index >> STRING_TABLE_CHUNK_BITS].store(new StringTableEntry[STRING_TABLE_CHUNK_SIZE], std::memory_order_release);
+            }
+        }
+        StringTableEntry& entry = at(index);
+        entry.text.assign(text.data(), text.size());
+        entry.hash = std::hash<std::string>()(entry.text);
+        entry.references.store(1, std::memory_order_relaxed);
+        entry.live = true;
+        ids[std::string_view(entry.text)] = (M1OrientationStringTable::Id)index;
+        if (index == count.load(std::memory_order_relaxed)) {
+            count.store(index + 1, std::memory_order_release);
+        }
+        liveCount.fetch_add(1, std::memory_order_relaxed);
+        return (M1OrientationStringTable::Id)index;
+    }
+
+    // Requires `mutex` held exclusively, frees the entry unless it was taken again meanwhile
+    void free(M1OrientationStringTable::Id id) {
+        StringTableEntry& entry = at(id);
+        if (!entry.live || entry.references.load(std::memory_order_acquire) != 0) {
+            return;
+        }
+        // The text is kept until the id is reused, so a reader racing the last release still
+        // sees a valid string
+        ids.erase(std::string_view(entry.text));
+        entry.live = false;
+        freeIds.push_back(id);
+        liveCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    StringTableEntry& at(std::size_t index) {
+        return chunks[index >> STRING_TABLE_CHUNK_BITS].load(std::memory_order_acquire)[index & (STRING_TABLE_CHUNK_SIZE - 1)];
+    }
+
+    const StringTableEntry& entry(M1OrientationStringTable::Id id) {
+        if (id >= count.load(std::memory_order_acquire)) {
+            id = M1OrientationStringTable::Empty;
+        }
+        return at(id);
+    }
+};
+
+StringTableStorage& getStringTableStorage() {
+    static StringTableStorage storage;
+    return storage;
+}
+
+}
+
+M1OrientationStringTable::Id M1OrientationStringTable::intern(std::string_view text) {
+    if (text.empty()) {
+        return Empty;
+    }
+    StringTableStorage& storage = getStringTableStorage();
+    {
+        // Entries are only freed under the exclusive lock, so a reference taken here keeps it
+        std::shared_lock<std::shared_mutex> lock(storage.mutex);
+        auto it = storage.ids.find(text);
+        if (it != storage.ids.end()) {
+            storage.at(it->second).references.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(storage.mutex);
+    auto it = storage.ids.find(text);
+    if (it != storage.ids.end()) {
+        storage.at(it->second).references.fetch_add(1, std::memory_order_relaxed);
+        return it->second;
+    }
+    return storage.append(text);
+}
+
+bool M1OrientationStringTable::find(std::string_view text, Id& id) {
+    StringTableStorage& storage = getStringTableStorage();
+    std::shared_lock<std::shared_mutex> lock(storage.mutex);
+    auto it = storage.ids.find(text);
+    if (it == storage.ids.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+const std::string& M1OrientationStringTable::get(Id id) {
+    return getStringTableStorage().entry(id).text;
+}
+
+std::size_t M1OrientationStringTable::getHash(Id id) {
+    return getStringTableStorage().entry(id).hash;
+}
+
+std::size_t M1OrientationStringTable::size() {
+    return getStringTableStorage().liveCount.load(std::memory_order_relaxed);
+}
+
+void M1OrientationStringTable::retainEntry(Id id) {
+    getStringTableStorage().at(id).references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void M1OrientationStringTable::releaseEntry(Id id) {
+    StringTableStorage& storage = getStringTableStorage();
+    if (storage.at(id).references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::unique_lock<std::shared_mutex> lock(storage.mutex);
+        storage.free(id);
+    }
+}
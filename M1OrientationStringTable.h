@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Process-wide table of interned strings (device names, addresses), so device infos can carry
+// small ids instead of strings. Equal strings live at the same time always get the same id and the
+// id of "" is 0. Each entry keeps its std::hash so device hashes are computed once per distinct string.
+//
+// Entries are reference counted through Ref, which is what device infos hold. An entry is freed
+// when its last Ref goes away and its id is reused for the next new string, so the table is bounded
+// by the strings in use rather than growing with every randomized BLE address ever seen.
+//
+// Lookups of strings already in the table take a shared lock, only adding or freeing an entry
+// takes it exclusively. get() and getHash() are lock-free for any id the calling thread holds a Ref to.
+class M1OrientationStringTable
+{
+public:
+    typedef uint32_t Id;
+    static const Id Empty = 0;
+
+    // Returns `text`'s id with one reference taken for the caller, see Ref::adopt()
+    static Id intern(std::string_view text);
+    // Looks a string up without adding it or taking a reference, the id can be freed and reused
+    // as soon as no Ref holds it
+    static bool find(std::string_view text, Id& id);
+    // The string stays valid while a Ref to `id` is alive
+    static const std::string& get(Id id);
+    static std::size_t getHash(Id id);
+    // Number of strings in use
+    static std::size_t size();
+
+    static void retain(Id id) {
+        if (id != Empty) {
+            retainEntry(id);
+        }
+    }
+
+    static void release(Id id) {
+        if (id != Empty) {
+            releaseEntry(id);
+        }
+    }
+
+    // One reference to an interned string, copying it takes another reference
+    class Ref
+    {
+    public:
+        Ref() = default;
+        explicit Ref(Id id_) : id(id_) {
+            retain(id);
+        }
+        // Takes over the reference intern() returned
+        static Ref adopt(Id id_) {
+            Ref ref;
+            ref.id = id_;
+            return ref;
+        }
+
+        Ref(const Ref& other) : id(other.id) {
+            retain(id);
+        }
+        Ref(Ref&& other) noexcept : id(other.id) {
+            other.id = Empty;
+        }
+        Ref& operator=(const Ref& other) {
+            if (id != other.id) {
+                retain(other.id);
+                release(id);
+                id = other.id;
+            }
+            return *this;
+        }
+        Ref& operator=(Ref&& other) noexcept {
+            if (this != &other) {
+                release(id);
+                id = other.id;
+                other.id = Empty;
+            }
+            return *this;
+        }
+        ~Ref() {
+            release(id);
+        }
+
+        Id get() const {
+            return id;
+        }
+
+        bool operator==(const Ref& rhs) const {
+            return id == rhs.id;
+        }
+        bool operator!=(const Ref& rhs) const {
+            return id != rhs.id;
+        }
+
+    private:
+        Id id = Empty;
+    };
+
+private:
+    static void retainEntry(Id id);
+    static void releaseEntry(Id id);
+};
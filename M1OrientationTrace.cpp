@@ -0,0 +1,170 @@
+#include "M1OrientationTrace.h"
+
+#include <cstring>
+#include <filesystem>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define M1_ORIENTATION_TRACE_MMAP 1
+#endif
+
+M1OrientationTraceWriter::~M1OrientationTraceWriter() {
+    close();
+}
+
+static bool isValidTraceHeader(const M1OrientationTraceHeader& header) {
+    return std::memcmp(header.magic, "M1OT", 4) == 0 && header.version == 1 && header.recordSize == sizeof(M1OrientationTraceRecord);
+}
+
+bool M1OrientationTraceWriter::open(const std::string& path) {
+    close();
+
+    // Appending to an existing trace keeps its header, so it has to be one of ours. A record left
+    // partial by a crash is cut off so the appended records stay aligned.
+    std::error_code error;
+    uintmax_t existingSize = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+    if (error) {
+        return false;
+    }
+    if (existingSize > 0) {
+        M1OrientationTraceHeader header;
+        std::FILE* existing = std::fopen(path.c_str(), "rb");
+        bool valid = existing != nullptr && std::fread(&header, sizeof(header), 1, existing) == 1 && isValidTraceHeader(header);
+        if (existing != nullptr) {
+            std::fclose(existing);
+        }
+        if (!valid) {
+            return false;
+        }
+        uintmax_t partialBytes = (existingSize - sizeof(M1OrientationTraceHeader)) % sizeof(M1OrientationTraceRecord);
+        if (partialBytes != 0) {
+            std::filesystem::resize_file(path, existingSize - partialBytes, error);
+            if (error) {
+                return false;
+            }
+        }
+    }
+
+    file = std::fopen(path.c_str(), "ab");
+    if (file == nullptr) {
+        return false;
+    }
+    buffer.resize(64 * 1024);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    recordCount = 0;
+    startingSession = true;
+    // The position of a file opened for appending is unspecified until the first write (MSVC reports
+    // 0), so the end is sought explicitly before deciding whether a header is needed
+    std::fseek(file, 0, SEEK_END);
+    if (std::ftell(file) == 0) {
+        M1OrientationTraceHeader header;
+        header.recordSize = sizeof(M1OrientationTraceRecord);
+        std::fwrite(&header, sizeof(header), 1, file);
+    }
+    return true;
+}
+
+void M1OrientationTraceWriter::close() {
+    if (file != nullptr) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+bool M1OrientationTraceWriter::isOpen() const {
+    return file != nullptr;
+}
+
+void M1OrientationTraceWriter::write(const M1OrientationTraceRecord& record) {
+    if (file == nullptr) {
+        return;
+    }
+    M1OrientationTraceRecord written = record;
+    if (startingSession) {
+        written.flags |= M1OrientationTraceRecord::SessionStart;
+    }
+    if (std::fwrite(&written, sizeof(written), 1, file) == 1) {
+        recordCount++;
+        startingSession = false;
+    }
+}
+
+void M1OrientationTraceWriter::flush() {
+    if (file != nullptr) {
+        std::fflush(file);
+    }
+}
+
+uint64_t M1OrientationTraceWriter::getRecordCount() const {
+    return recordCount;
+}
+
+M1OrientationTraceReader::~M1OrientationTraceReader() {
+    close();
+}
+
+bool M1OrientationTraceReader::open(const std::string& path) {
+    close();
+
+#if M1_ORIENTATION_TRACE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || (size_t)fileInfo.st_size < sizeof(M1OrientationTraceHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    mappedData = data;
+    mappedSize = (size_t)fileInfo.st_size;
+
+    const M1OrientationTraceHeader* header = (const M1OrientationTraceHeader*)mappedData;
+    if (!isValidTraceHeader(*header)) {
+        close();
+        return false;
+    }
+    records = (const M1OrientationTraceRecord*)((const char*)mappedData + sizeof(M1OrientationTraceHeader));
+    recordCount = (mappedSize - sizeof(M1OrientationTraceHeader)) / sizeof(M1OrientationTraceRecord);
+#else
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    M1OrientationTraceHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || !isValidTraceHeader(header)) {
+        std::fclose(file);
+        return false;
+    }
+    M1OrientationTraceRecord record;
+    while (std::fread(&record, sizeof(record), 1, file) == 1) {
+        loadedRecords.push_back(record);
+    }
+    std::fclose(file);
+    records = loadedRecords.data();
+    recordCount = loadedRecords.size();
+#endif
+    return true;
+}
+
+void M1OrientationTraceReader::close() {
+#if M1_ORIENTATION_TRACE_MMAP
+    if (mappedData != nullptr) {
+        munmap(mappedData, mappedSize);
+    }
+#endif
+    mappedData = nullptr;
+    mappedSize = 0;
+    loadedRecords.clear();
+    records = nullptr;
+    recordCount = 0;
+}
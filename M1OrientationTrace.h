@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Compact binary trace of received orientation samples, used to reproduce a user's head motion
+// and as deterministic input for regression tests. The file is a fixed header followed by
+// fixed size records in native (little endian) byte order, so it can be memory mapped and
+// indexed directly. Writing appends only, each time a trace is opened for writing starts a new
+// session whose first record is flagged SessionStart, since its timestamps come from a different
+// steady clock origin than the records before it.
+struct M1OrientationTraceHeader {
+    char magic[4] = { 'M', '1', 'O', 'T' };
+    uint32_t version = 1;
+    uint32_t recordSize = 0;
+    uint32_t reserved = 0;
+};
+
+struct M1OrientationTraceRecord {
+    enum Flags : uint32_t {
+        MainOrientation = 1 << 0, // sample of getOrientation()
+        DeviceStream = 1 << 1, // sample of a subscribed device stream
+        SessionStart = 1 << 2, // first record written after the trace was opened, replay timing restarts here
+        TrackingYawEnabled = 1 << 8,
+        TrackingPitchEnabled = 1 << 9,
+        TrackingRollEnabled = 1 << 10,
+        TrackingYawInverted = 1 << 11,
+        TrackingPitchInverted = 1 << 12,
+        TrackingRollInverted = 1 << 13,
+    };
+
+    int64_t timestampMicros = 0; // capture time in the client's steady clock, as in the orientation history
+    uint32_t sequence = 0;
+    uint32_t flags = 0;
+    float quaternion[4] = { 1, 0, 0, 0 }; // w, x, y, z
+    uint64_t deviceHandle = 0;
+};
+
+static_assert(sizeof(M1OrientationTraceRecord) == 40, "trace records are written to disk as-is");
+
+class M1OrientationTraceWriter
+{
+    std::FILE* file = nullptr;
+    std::vector<char> buffer;
+    uint64_t recordCount = 0;
+    bool startingSession = false; // the next record written gets SessionStart
+
+public:
+    ~M1OrientationTraceWriter();
+
+    // Creates the file or appends to an existing trace, false for files that aren't a trace
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+    // Buffered, no syscall per record
+    void write(const M1OrientationTraceRecord& record);
+    void flush();
+    uint64_t getRecordCount() const;
+};
+
+class M1OrientationTraceReader
+{
+    const M1OrientationTraceRecord* records = nullptr;
+    size_t recordCount = 0;
+    void* mappedData = nullptr;
+    size_t mappedSize = 0;
+    std::vector<M1OrientationTraceRecord> loadedRecords; // used where memory mapping isn't available
+
+public:
+    ~M1OrientationTraceReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    size_t size() const {
+        return recordCount;
+    }
+
+    const M1OrientationTraceRecord& operator[](size_t index) const {
+        return records[index];
+    }
+};
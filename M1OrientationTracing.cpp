@@ -0,0 +1,84 @@
+#include "M1OrientationTracing.h"
+
+#if M1_ORIENTATION_TRACING
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> M1OrientationTracing::enabled { false };
+
+// Rings are registered once per thread and kept for the life of the process so exports
+// still see threads that have exited
+static std::mutex ringsMutex;
+static std::vector<std::unique_ptr<M1OrientationTracing::ThreadRing>> rings;
+
+int64_t M1OrientationTracing::nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void M1OrientationTracing::setEnabled(bool enable) {
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+M1OrientationTracing::ThreadRing& M1OrientationTracing::getThreadRing() {
+    thread_local ThreadRing* ring = nullptr;
+    if (ring == nullptr) {
+        auto newRing = std::make_unique<ThreadRing>();
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        newRing->threadId = rings.size() + 1; // small ids read better in trace viewers
+        ring = newRing.get();
+        rings.push_back(std::move(newRing));
+    }
+    return *ring;
+}
+
+void M1OrientationTracing::record(const char* name, int64_t startMicros, int64_t endMicros) {
+    // Single producer per ring: only the owning thread writes, the index is published last
+    ThreadRing& ring = getThreadRing();
+    uint64_t index = ring.written.load(std::memory_order_relaxed);
+    ring.events[index % RING_SIZE] = { name, startMicros, endMicros - startMicros };
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+std::string M1OrientationTracing::exportChromeTrace() {
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (auto& ring : rings) {
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        uint64_t count = written < (uint64_t)RING_SIZE ? written : (uint64_t)RING_SIZE;
+        for (uint64_t i = written - count; i < written; i++) {
+            const Event& event = ring->events[i % RING_SIZE];
+            if (!first) {
+                json += ",";
+            }
+            first = false;
+            json += "{\"name\":\"" + std::string(event.name) + "\",\"cat\":\"m1_orientation_client\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(ring->threadId)
+                + ",\"ts\":" + std::to_string(event.startMicros) + ",\"dur\":" + std::to_string(event.durationMicros) + "}";
+        }
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}";
+    return json;
+}
+
+bool M1OrientationTracing::writeChromeTrace(const std::string& path) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    file << exportChromeTrace();
+    return (bool)file;
+}
+
+void M1OrientationTracing::clear() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (auto& ring : rings) {
+        ring->written.store(0, std::memory_order_relaxed);
+    }
+}
+
+#endif
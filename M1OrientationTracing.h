@@ -0,0 +1,73 @@
+#pragma once
+
+// Optional per-stage trace spans (receive, parse, publish, commands).
+// Compiled out entirely unless M1_ORIENTATION_TRACING is set to 1, in which case spans are
+// written to a lock-free ring per thread and can be exported as Chrome trace JSON
+// (chrome://tracing or ui.perfetto.dev). A thread's first span allocates its ring and registers
+// it under a lock, so the real-time reads (see M1OrientationRealtimeAudit.h) carry no spans.
+
+#ifndef M1_ORIENTATION_TRACING
+#define M1_ORIENTATION_TRACING 0
+#endif
+
+#if M1_ORIENTATION_TRACING
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class M1OrientationTracing
+{
+public:
+    struct Event {
+        const char* name; // must be a string literal
+        int64_t startMicros;
+        int64_t durationMicros;
+    };
+
+    static constexpr int RING_SIZE = 8192; // events kept per thread, older ones are overwritten
+
+    struct ThreadRing {
+        uint64_t threadId = 0;
+        std::atomic<uint64_t> written { 0 };
+        Event events[RING_SIZE];
+    };
+
+    class Span {
+        const char* name;
+        int64_t startMicros;
+    public:
+        explicit Span(const char* name_) : name(name_), startMicros(isEnabled() ? nowMicros() : 0) {}
+        ~Span() {
+            if (startMicros != 0) {
+                record(name, startMicros, nowMicros());
+            }
+        }
+    };
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    static void record(const char* name, int64_t startMicros, int64_t endMicros);
+    static std::string exportChromeTrace(); // most accurate while the traced threads are idle
+    static bool writeChromeTrace(const std::string& path);
+    static void clear();
+
+    static int64_t nowMicros();
+
+private:
+    static std::atomic<bool> enabled;
+    static ThreadRing& getThreadRing();
+};
+
+#define M1_ORIENTATION_TRACE_CONCAT_INNER(a, b) a##b
+#define M1_ORIENTATION_TRACE_CONCAT(a, b) M1_ORIENTATION_TRACE_CONCAT_INNER(a, b)
+#define M1_ORIENTATION_TRACE_SPAN(name) M1OrientationTracing::Span M1_ORIENTATION_TRACE_CONCAT(m1OrientationTraceSpan, __LINE__)(name)
+
+#else
+
+#define M1_ORIENTATION_TRACE_SPAN(name)
+
+#endif
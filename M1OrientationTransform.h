@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "m1_mathematics/Orientation.h"
+
+// Client-side orientation transform pipeline: recenter, axis masking/inversion, smoothing and
+// coordinate convention changes applied once per received sample on the polling thread, so every
+// reader of M1OrientationClient::getOrientation() sees the same transformed orientation.
+//
+// Stages are plain structs composed at compile time with M1OrientationPipeline<Stages...>, only the
+// stages listed are compiled in and their process() calls inline into one pass. The client holds the
+// pipeline through the M1OrientationTransform interface, a single virtual call per sample.
+
+// Quaternion helpers for the stages, (w, x, y, z) as in Mach1::Quaternion
+struct M1OrientationQuaternion {
+    static Mach1::Quaternion identity() {
+        return Mach1::Quaternion(1.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    // Hamilton product
+    static Mach1::Quaternion multiply(const Mach1::Quaternion& a, const Mach1::Quaternion& b) {
+        return Mach1::Quaternion(a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+                                 a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                                 a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                                 a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w);
+    }
+
+    static Mach1::Quaternion conjugate(const Mach1::Quaternion& q) {
+        return Mach1::Quaternion(q.w, -q.x, -q.y, -q.z);
+    }
+
+    static float dot(const Mach1::Quaternion& a, const Mach1::Quaternion& b) {
+        return a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    static Mach1::Quaternion normalize(const Mach1::Quaternion& q) {
+        float norm = std::sqrt(dot(q, q));
+        if (!(norm > 0.0f)) {
+            return identity();
+        }
+        return Mach1::Quaternion(q.w / norm, q.x / norm, q.y / norm, q.z / norm);
+    }
+
+    // Shortest path interpolation from `a` (t = 0) to `b` (t = 1)
+    static Mach1::Quaternion slerp(const Mach1::Quaternion& a, Mach1::Quaternion b, float t) {
+        float cosTheta = dot(a, b);
+        if (cosTheta < 0.0f) {
+            b = Mach1::Quaternion(-b.w, -b.x, -b.y, -b.z);
+            cosTheta = -cosTheta;
+        }
+        float wa = 1.0f - t, wb = t;
+        if (cosTheta < 0.9995f) {
+            // Close rotations fall back to the normalized lerp below
+            float theta = std::acos(cosTheta);
+            float sinTheta = std::sin(theta);
+            wa = std::sin(wa * theta) / sinTheta;
+            wb = std::sin(wb * theta) / sinTheta;
+        }
+        return normalize(Mach1::Quaternion(wa * a.w + wb * b.w, wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z));
+    }
+};
+
+// Change of coordinate convention. Output axis i is input axis `axes[i]` scaled by `signs[i]` (a
+// signed axis permutation, which covers axis order and handedness changes), then the result is
+// expressed in the `basis` rotated frame (e.g. a different forward direction).
+struct M1OrientationConvention {
+    int axes[3] = { 0, 1, 2 };
+    float signs[3] = { 1.0f, 1.0f, 1.0f };
+    Mach1::Quaternion basis = M1OrientationQuaternion::identity();
+
+    // Factors for the permuted vector part of a quaternion, output component i is `scales[i]` times
+    // input component `axes[i]`. Conjugating by an improper permutation (odd parity or odd number of
+    // flips) reverses the rotation sense, which shows up as a negated vector part.
+    void getVectorScales(float scales[3]) const {
+        float parity = ((axes[1] - axes[0] + 3) % 3 == 1) ? 1.0f : -1.0f;
+        float determinant = parity * signs[0] * signs[1] * signs[2];
+        for (int i = 0; i < 3; i++) {
+            scales[i] = determinant * signs[i];
+        }
+    }
+
+    // Checked on the fields as set rather than after normalizing, any basis without a vector part
+    // is the identity rotation
+    bool isIdentity() const {
+        return axes[0] == 0 && axes[1] == 1 && axes[2] == 2
+            && signs[0] == 1.0f && signs[1] == 1.0f && signs[2] == 1.0f
+            && basis.x == 0.0f && basis.y == 0.0f && basis.z == 0.0f;
+    }
+
+    Mach1::Quaternion apply(const Mach1::Quaternion& q) const {
+        float scales[3];
+        getVectorScales(scales);
+        const float v[3] = { q.x, q.y, q.z };
+        Mach1::Quaternion mapped(q.w, scales[0] * v[axes[0]], scales[1] * v[axes[1]], scales[2] * v[axes[2]]);
+        return M1OrientationQuaternion::multiply(M1OrientationQuaternion::conjugate(basis), M1OrientationQuaternion::multiply(mapped, basis));
+    }
+};
+
+class M1OrientationTransform
+{
+public:
+    virtual ~M1OrientationTransform() {}
+
+    // Called on the polling thread for each sample, timestamps are steady clock microseconds
+    virtual Mach1::Quaternion process(const Mach1::Quaternion& rotation, int64_t timestampMicros) = 0;
+    // Makes the most recent input the new forward direction, for stages that support it
+    virtual void recenter() {}
+    // Drops filter state, e.g. after a device change
+    virtual void reset() {}
+};
+
+// Subtracts a reference orientation captured by recenter(), identity until then
+struct M1OrientationRecenterStage {
+    Mach1::Quaternion offset = M1OrientationQuaternion::identity();
+    Mach1::Quaternion lastInput = M1OrientationQuaternion::identity();
+
+    Mach1::Quaternion process(const Mach1::Quaternion& rotation, int64_t) {
+        lastInput = rotation;
+        return M1OrientationQuaternion::multiply(offset, rotation);
+    }
+
+    // The offset is kept across reset(), assign `offset` to clear it
+    void recenter() {
+        offset = M1OrientationQuaternion::conjugate(M1OrientationQuaternion::normalize(lastInput));
+    }
+};
+
+// Per-axis masking and inversion in yaw/pitch/roll, as scale factors so it stays branch-free:
+// 1 passes the axis, -1 inverts it and 0 masks it
+struct M1OrientationAxisStage {
+    float yawScale = 1.0f;
+    float pitchScale = 1.0f;
+    float rollScale = 1.0f;
+
+    void setAxes(const bool enabled[3], const bool inverted[3]) {
+        float* scales[3] = { &yawScale, &pitchScale, &rollScale };
+        for (int i = 0; i < 3; i++) {
+            *scales[i] = enabled[i] ? (inverted[i] ? -1.0f : 1.0f) : 0.0f;
+        }
+    }
+
+    Mach1::Quaternion process(const Mach1::Quaternion& rotation, int64_t) {
+        // Through Mach1::Orientation so the euler order matches the rest of the library
+        Mach1::Orientation orientation;
+        orientation.SetRotation(rotation);
+        Mach1::Float3 euler = orientation.GetGlobalRotationAsEulerRadians();
+        orientation.SetRotation(Mach1::Float3(euler.GetYaw() * yawScale, euler.GetPitch() * pitchScale, euler.GetRoll() * rollScale));
+        return orientation.GetGlobalRotationAsQuaternion();
+    }
+};
+
+// Exponential smoothing along the shortest arc, `timeConstantSeconds` is the time to cover ~63% of a step
+struct M1OrientationSmoothingStage {
+    double timeConstantSeconds = 0.05;
+    Mach1::Quaternion state = M1OrientationQuaternion::identity();
+    int64_t lastTimestampMicros = 0;
+    bool hasState = false;
+
+    Mach1::Quaternion process(const Mach1::Quaternion& rotation, int64_t timestampMicros) {
+        if (!hasState || timeConstantSeconds <= 0) {
+            state = rotation;
+            lastTimestampMicros = timestampMicros;
+        } else if (timestampMicros > lastTimestampMicros) {
+            double elapsedSeconds = (timestampMicros - lastTimestampMicros) / 1000000.0;
+            state = M1OrientationQuaternion::slerp(state, rotation, (float)(1.0 - std::exp(-elapsedSeconds / timeConstantSeconds)));
+            lastTimestampMicros = timestampMicros;
+        }
+        // Samples that are not newer than the last one leave the state as is
+        hasState = true;
+        return state;
+    }
+
+    void reset() {
+        hasState = false;
+        lastTimestampMicros = 0;
+    }
+};
+
+struct M1OrientationConventionStage {
+    M1OrientationConvention convention;
+
+    Mach1::Quaternion process(const Mach1::Quaternion& rotation, int64_t) {
+        return convention.apply(rotation);
+    }
+};
+
+template <typename... Stages>
+class M1OrientationPipeline : public M1OrientationTransform
+{
+public:
+    std::tuple<Stages...> stages;
+
+    M1OrientationPipeline() {}
+    explicit M1OrientationPipeline(Stages... stages_) : stages(std::move(stages_)...) {}
+
+    template <typename Stage>
+    Stage& get() {
+        return std::get<Stage>(stages);
+    }
+
+    // Non-virtual entry point for callers that know the pipeline type
+    Mach1::Quaternion apply(Mach1::Quaternion rotation, int64_t timestampMicros) {
+        std::apply([&](auto&... stage) {
+            ((rotation = stage.process(rotation, timestampMicros)), ...);
+        }, stages);
+        return rotation;
+    }
+
+    Mach1::Quaternion process(const Mach1::Quaternion& rotation, int64_t timestampMicros) override {
+        return apply(rotation, timestampMicros);
+    }
+
+    void recenter() override {
+        std::apply([](auto&... stage) {
+            (callRecenter(stage, 0), ...);
+        }, stages);
+    }
+
+    void reset() override {
+        std::apply([](auto&... stage) {
+            (callReset(stage, 0), ...);
+        }, stages);
+    }
+
+private:
+    // Stages without recenter() or reset() are skipped at compile time
+    template <typename Stage>
+    static auto callRecenter(Stage& stage, int) -> decltype(stage.recenter(), void()) {
+        stage.recenter();
+    }
+    template <typename Stage>
+    static void callRecenter(Stage&, long) {}
+
+    template <typename Stage>
+    static auto callReset(Stage& stage, int) -> decltype(stage.reset(), void()) {
+        stage.reset();
+    }
+    template <typename Stage>
+    static void callReset(Stage&, long) {}
+};
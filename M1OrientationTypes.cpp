@@ -8,7 +8,7 @@ std::map<enum M1OrientationDeviceType, std::string> M1OrientationDeviceTypeName
     { M1OrientationManagerDeviceTypeOSC, "OSC"},
     { M1OrientationManagerDeviceTypeCamera, "Camera"},
     { M1OrientationManagerDeviceTypeEmulator, "Emulator"},
-    { M1OrientationManagerDeviceTypeFusion, "Fusion"}, // TODO: Add Camera + [any] type
+    { M1OrientationManagerDeviceTypeFusion, "Fusion"}, // Camera + [any] type
 };
 
 std::map<enum M1OrientationStatusType, std::string> M1OrientationStatusTypeName = {
@@ -17,3 +17,28 @@ std::map<enum M1OrientationStatusType, std::string> M1OrientationStatusTypeName
     { M1OrientationManagerStatusTypeConnectable, "Connectable"},
     { M1OrientationManagerStatusTypeConnected, "Connected"},
 };
+
+void M1OrientationDiffDeviceLists(const std::vector<M1OrientationDeviceInfo>& previous, const M1OrientationDeviceIndex& previousIndex,
+                                  const std::vector<M1OrientationDeviceInfo>& current, const M1OrientationDeviceIndex& currentIndex,
+                                  std::vector<M1OrientationDeviceEvent>& events) {
+    for (std::size_t i = 0; i < current.size(); i++) {
+        M1OrientationDeviceHandle handle = current[i].getDeviceHandle();
+        if (currentIndex.find(handle) != (int)i) {
+            continue; // repeated handle, reported once
+        }
+        int previousPosition = previousIndex.find(handle);
+        if (previousPosition < 0) {
+            events.push_back({ M1OrientationDeviceEventAdded, handle, (int)i });
+        } else if (!previous[previousPosition].hasSameState(current[i])) {
+            events.push_back({ M1OrientationDeviceEventUpdated, handle, (int)i });
+        }
+    }
+
+    // Removals in the previous list order
+    for (std::size_t i = 0; i < previous.size(); i++) {
+        M1OrientationDeviceHandle handle = previous[i].getDeviceHandle();
+        if (previousIndex.find(handle) == (int)i && currentIndex.find(handle) < 0) {
+            events.push_back({ M1OrientationDeviceEventRemoved, handle, (int)i });
+        }
+    }
+}
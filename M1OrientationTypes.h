@@ -1,14 +1,22 @@
 #pragma once
 
 #include "m1_mathematics/Orientation.h"
+#include "M1OrientationStringTable.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <map>
 #include <mutex>
 #include <variant>
 
+#ifndef M1_ORIENTATION_COMPACT_DEVICE_INFO
+#define M1_ORIENTATION_COMPACT_DEVICE_INFO 0
+#endif
+
 struct M1OrientationTrackingResult {
     Mach1::Orientation currentOrientation;
     bool success;
@@ -21,7 +29,7 @@ enum M1OrientationDeviceType {
     M1OrientationManagerDeviceTypeBLE,
     M1OrientationManagerDeviceTypeOSC,
     M1OrientationManagerDeviceTypeCamera,
-    M1OrientationManagerDeviceTypeFusion, // TODO: Add Camera + [any] type
+    M1OrientationManagerDeviceTypeFusion, // Camera + [any] type, see M1OrientationFusion
 };
 
 extern std::map<enum M1OrientationDeviceType, std::string> M1OrientationDeviceTypeName;
@@ -35,61 +43,119 @@ enum M1OrientationStatusType {
 
 extern std::map<enum M1OrientationStatusType, std::string> M1OrientationStatusTypeName;
 
+// Stable identifier of a device across device list refreshes, derived from M1OrientationDeviceInfo::Hash
+typedef std::size_t M1OrientationDeviceHandle;
+static const M1OrientationDeviceHandle M1OrientationDeviceHandleNone = 0;
+
+// Rarely set per-device fields. In the compact layout they are shared between copies of a
+// M1OrientationDeviceInfo and copied on write so the device info itself stays small
+struct M1OrientationDeviceExtras {
+    std::string error = "";
+    // osc specific
+    int osc_port = 9901;
+    std::string osc_msg_addr_pttrn = "/orientation";
+
+    bool operator==(const M1OrientationDeviceExtras& rhs) const {
+        return error == rhs.error && osc_port == rhs.osc_port && osc_msg_addr_pttrn == rhs.osc_msg_addr_pttrn;
+    }
+};
+
+// Name and address are interned in M1OrientationStringTable and the hash is computed once at
+// construction, so copies, hashing and comparisons don't touch the strings. With
+// M1_ORIENTATION_COMPACT_DEVICE_INFO the remaining fields are packed behind their accessors too and
+// the struct fits in a cache line (checked below). By default they stay public as they always were,
+// which keeps two std::strings and two variants inline: smaller than with inline name and address
+// strings, but about two cache lines, so the cache line size is only met by the compact layout.
 struct M1OrientationDeviceInfo {
 public:
     // Constructor
-    M1OrientationDeviceInfo() {}
-    M1OrientationDeviceInfo(std::string name_, M1OrientationDeviceType type_, std::string address_, std::variant<bool, int> signalStrength_ = false, std::variant<bool, int> batteryPercentage_ = false) {
-        name = name_;
-        type = type_;
-        address = address_;
-        signalStrength = signalStrength_;
-        batteryPercentage = batteryPercentage_;
+    M1OrientationDeviceInfo() : hash(getEmptyHash()) {}
+    M1OrientationDeviceInfo(const std::string& name_, M1OrientationDeviceType type_, const std::string& address_, std::variant<bool, int> signalStrength_ = false, std::variant<bool, int> batteryPercentage_ = false) {
+        nameId = M1OrientationStringTable::Ref::adopt(M1OrientationStringTable::intern(name_));
+        addressId = M1OrientationStringTable::Ref::adopt(M1OrientationStringTable::intern(address_));
+        hash = computeHash(nameId.get(), addressId.get());
+        type = (int8_t)type_;
+        setDeviceSignalStrength(signalStrength_);
+        setDeviceBatteryPercentage(batteryPercentage_);
+    }
+    // From already interned strings, e.g. by a parser reading them without a copy
+    M1OrientationDeviceInfo(const M1OrientationStringTable::Ref& nameId_, M1OrientationDeviceType type_, const M1OrientationStringTable::Ref& addressId_, std::variant<bool, int> signalStrength_ = false, std::variant<bool, int> batteryPercentage_ = false) {
+        nameId = nameId_;
+        addressId = addressId_;
+        hash = computeHash(nameId.get(), addressId.get());
+        type = (int8_t)type_;
+        setDeviceSignalStrength(signalStrength_);
+        setDeviceBatteryPercentage(batteryPercentage_);
     }
 
     struct Hash {
         std::size_t operator()(const M1OrientationDeviceInfo& k) const
         {
-            // Joshua Bloch, Effective Java, Addison-Wesley Professional (2018), p. 53
-            std::size_t result = k.getDeviceNameHash();
-            result = 31 * result + k.getDeviceAddressHash();
-            return result;
+            return k.hash;
         }
     };
 
-    std::string getDeviceName() {
-        return name;
+    M1OrientationDeviceHandle getDeviceHandle() const {
+        return toHandle(hash);
+    }
+
+    // Handle of the device with this name and address without constructing it,
+    // M1OrientationDeviceHandleNone if no device with these strings was ever seen
+    static M1OrientationDeviceHandle findDeviceHandle(const std::string& name, const std::string& address) {
+        M1OrientationStringTable::Id nameId, addressId;
+        if (!M1OrientationStringTable::find(name, nameId) || !M1OrientationStringTable::find(address, addressId)) {
+            return M1OrientationDeviceHandleNone;
+        }
+        return toHandle(computeHash(nameId, addressId));
+    }
+
+    const std::string& getDeviceName() const {
+        return M1OrientationStringTable::get(nameId.get());
+    }
+
+    const M1OrientationStringTable::Ref& getDeviceNameRef() const {
+        return nameId;
     }
 
     std::size_t getDeviceNameHash() const {
-        return std::hash<std::string>()( name );
+        return M1OrientationStringTable::getHash(nameId.get());
     }
 
     bool isDeviceName(const std::string& query_name) const {
-        return name.find(query_name) != std::string::npos;
+        return getDeviceName().find(query_name) != std::string::npos;
     }
 
-    M1OrientationDeviceType getDeviceType() {
-        return type;
+    M1OrientationDeviceType getDeviceType() const {
+        return (M1OrientationDeviceType)type;
     }
     
-    std::string getDeviceAddress() {
+    const std::string& getDeviceAddress() const {
         // [Serial]: returns the path
         // [BLE]: returns the UUID
-        return address;
+        return M1OrientationStringTable::get(addressId.get());
+    }
+
+    const M1OrientationStringTable::Ref& getDeviceAddressRef() const {
+        return addressId;
     }
 
     std::size_t getDeviceAddressHash() const {
-        return std::hash<std::string>()( address);
+        return M1OrientationStringTable::getHash(addressId.get());
     }
 
     bool isDeviceAddress(const std::string& query_address) const {
-        return address.find(query_address) != std::string::npos;
+        return getDeviceAddress().find(query_address) != std::string::npos;
     }
 
-    // Keeping these getters for ease of documentation but these variables are now public
-    std::variant<bool, int> getDeviceSignalStrength() {
+    std::variant<bool, int> getDeviceSignalStrength() const {
+#if M1_ORIENTATION_COMPACT_DEVICE_INFO
+        if (signalStrength == UNKNOWN_VALUE) {
+            return false;
+        }
+        return (int)signalStrength;
+#else
         return signalStrength;
+#endif
         
         /* Reference:
         if (std::holds_alternative<bool>(signalStrength)) {
@@ -100,9 +166,23 @@ public:
         */
     }
     
-    // Keeping these getters for ease of documentation but these variables are now public
-    std::variant<bool, int> getDeviceBatteryPercentage() {
+    void setDeviceSignalStrength(std::variant<bool, int> signalStrength_) {
+#if M1_ORIENTATION_COMPACT_DEVICE_INFO
+        signalStrength = pack(signalStrength_);
+#else
+        signalStrength = signalStrength_;
+#endif
+    }
+    
+    std::variant<bool, int> getDeviceBatteryPercentage() const {
+#if M1_ORIENTATION_COMPACT_DEVICE_INFO
+        if (batteryPercentage == UNKNOWN_VALUE) {
+            return false;
+        }
+        return (int)batteryPercentage;
+#else
         return batteryPercentage;
+#endif
         
         /* Reference:
         if (std::holds_alternative<bool>(batteryPercentage)) {
@@ -113,37 +193,235 @@ public:
         */
     }
     
+    void setDeviceBatteryPercentage(std::variant<bool, int> batteryPercentage_) {
+#if M1_ORIENTATION_COMPACT_DEVICE_INFO
+        batteryPercentage = pack(batteryPercentage_);
+#else
+        batteryPercentage = batteryPercentage_;
+#endif
+    }
+    
+#if M1_ORIENTATION_COMPACT_DEVICE_INFO
+    const std::string& getError() const {
+        return getExtras().error;
+    }
+    
+    void setError(const std::string& error_) {
+        editExtras().error = error_;
+    }
+    
+    int getOscPort() const {
+        return getExtras().osc_port;
+    }
+    
+    void setOscPort(int osc_port_) {
+        editExtras().osc_port = osc_port_;
+    }
+    
+    const std::string& getOscMessageAddressPattern() const {
+        return getExtras().osc_msg_addr_pttrn;
+    }
+    
+    void setOscMessageAddressPattern(const std::string& osc_msg_addr_pttrn_) {
+        editExtras().osc_msg_addr_pttrn = osc_msg_addr_pttrn_;
+    }
+#else
+    const std::string& getError() const {
+        return error;
+    }
+    
+    void setError(const std::string& error_) {
+        error = error_;
+    }
+    
+    int getOscPort() const {
+        return osc_port;
+    }
+    
+    void setOscPort(int osc_port_) {
+        osc_port = osc_port_;
+    }
+    
+    const std::string& getOscMessageAddressPattern() const {
+        return osc_msg_addr_pttrn;
+    }
+    
+    void setOscMessageAddressPattern(const std::string& osc_msg_addr_pttrn_) {
+        osc_msg_addr_pttrn = osc_msg_addr_pttrn_;
+    }
+#endif
+    
     // Custom search function for string name of device
     struct find_id {
-        std::string name;
-        find_id(std::string name):name(name) { }
+        M1OrientationStringTable::Id nameId = M1OrientationStringTable::Empty;
+        bool known = false; // names that were never interned can't match any device
+        find_id(const std::string& name) {
+            known = M1OrientationStringTable::find(name, nameId);
+        }
         bool operator()(M1OrientationDeviceInfo const& m) const {
-            return m.name == name;
+            return known && m.nameId.get() == nameId;
         }
     };
     
     bool operator==(const M1OrientationDeviceInfo& rhs) const {
-        return ((name == rhs.name) && (address == rhs.address));
+        return ((nameId == rhs.nameId) && (addressId == rhs.addressId));
     }
     
     bool operator!=(const M1OrientationDeviceInfo& rhs) const {
-        return ((name != rhs.name) || (address != rhs.address));
+        return ((nameId != rhs.nameId) || (addressId != rhs.addressId));
+    }
+    
+    // Same device (see operator==) with the same reported status, signal, battery and settings
+    bool hasSameState(const M1OrientationDeviceInfo& rhs) const {
+        return type == rhs.type && signalStrength == rhs.signalStrength && batteryPercentage == rhs.batteryPercentage
+            && notConnectable == rhs.notConnectable
+#if M1_ORIENTATION_COMPACT_DEVICE_INFO
+            && (extras == rhs.extras || getExtras() == rhs.getExtras());
+#else
+            && error == rhs.error && osc_port == rhs.osc_port && osc_msg_addr_pttrn == rhs.osc_msg_addr_pttrn;
+#endif
     }
 
 public:
     bool notConnectable = false;
     bool newErrorToParse = false;
+#if !M1_ORIENTATION_COMPACT_DEVICE_INFO
     std::string error = "";
     // osc specific
     int osc_port = 9901;
     std::string osc_msg_addr_pttrn = "/orientation";
 
+    std::variant<bool, int> signalStrength = false;
+    std::variant<bool, int> batteryPercentage = false;
+#endif
+
 private:
-    std::string name = "";
-    M1OrientationDeviceType type = M1OrientationDeviceType::M1OrientationManagerDeviceTypeNone;
-    std::string address = ""; // Device path or UUID
+    std::size_t hash = 0;
+    M1OrientationStringTable::Ref nameId;
+    M1OrientationStringTable::Ref addressId; // Device path or UUID
+    int8_t type = M1OrientationDeviceType::M1OrientationManagerDeviceTypeNone;
+#if M1_ORIENTATION_COMPACT_DEVICE_INFO
+    static constexpr int16_t UNKNOWN_VALUE = INT16_MIN;
+
+    int16_t signalStrength = UNKNOWN_VALUE;
+    int16_t batteryPercentage = UNKNOWN_VALUE;
+    std::shared_ptr<M1OrientationDeviceExtras> extras; // null until one of the extras is set
+#endif
+
+    static std::size_t computeHash(M1OrientationStringTable::Id nameId, M1OrientationStringTable::Id addressId) {
+        // Joshua Bloch, Effective Java, Addison-Wesley Professional (2018), p. 53
+        std::size_t result = M1OrientationStringTable::getHash(nameId);
+        result = 31 * result + M1OrientationStringTable::getHash(addressId);
+        return result;
+    }
+
+    static M1OrientationDeviceHandle toHandle(std::size_t hash) {
+        return hash == M1OrientationDeviceHandleNone ? 1 : hash; // 0 is reserved for "no device"
+    }
+
+    static std::size_t getEmptyHash() {
+        static const std::size_t emptyHash = computeHash(M1OrientationStringTable::Empty, M1OrientationStringTable::Empty);
+        return emptyHash;
+    }
+
+#if M1_ORIENTATION_COMPACT_DEVICE_INFO
+    static int16_t pack(const std::variant<bool, int>& value) {
+        if (std::holds_alternative<bool>(value)) {
+            return UNKNOWN_VALUE;
+        }
+        return (int16_t)std::max(INT16_MIN + 1, std::min(INT16_MAX, std::get<int>(value)));
+    }
+
+    const M1OrientationDeviceExtras& getExtras() const {
+        static const M1OrientationDeviceExtras defaultExtras;
+        return extras ? *extras : defaultExtras;
+    }
+
+    M1OrientationDeviceExtras& editExtras() {
+        // Copy on write, other copies of this device keep their extras
+        extras = extras ? std::make_shared<M1OrientationDeviceExtras>(*extras) : std::make_shared<M1OrientationDeviceExtras>();
+        return *extras;
+    }
+#endif
+};
+
+#if M1_ORIENTATION_COMPACT_DEVICE_INFO
+static_assert(sizeof(M1OrientationDeviceInfo) <= 64, "the compact M1OrientationDeviceInfo must fit in a cache line");
+#endif
+
+enum M1OrientationDeviceEventType {
+    M1OrientationDeviceEventAdded = 0,
+    M1OrientationDeviceEventRemoved,
+    M1OrientationDeviceEventUpdated, // signal strength, battery, status or settings changed
+};
+
+struct M1OrientationDeviceEvent {
+    M1OrientationDeviceEventType type = M1OrientationDeviceEventAdded;
+    M1OrientationDeviceHandle handle = M1OrientationDeviceHandleNone;
+    int index = -1; // in the current list, in the previous list for removed devices
+};
 
+// Handle -> position in a device list. A flat open-addressing table whose storage is reused across
+// rebuilds, so indexing the device list every poll stops allocating once it has grown to fit.
+// The first of several devices with the same handle wins.
+class M1OrientationDeviceIndex {
 public:
-    std::variant<bool, int> signalStrength = false;
-    std::variant<bool, int> batteryPercentage = false;
+    void rebuild(const std::vector<M1OrientationDeviceInfo>& devices) {
+        std::size_t capacity = 8;
+        while (capacity < devices.size() * 2) {
+            capacity *= 2; // at most half full, probes stay short and always reach an empty slot
+        }
+        if (slots.size() < capacity) {
+            slots.resize(capacity);
+        }
+        std::fill(slots.begin(), slots.end(), Slot());
+        mask = slots.size() - 1;
+        for (std::size_t i = 0; i < devices.size(); i++) {
+            M1OrientationDeviceHandle handle = devices[i].getDeviceHandle();
+            std::size_t slot = getFirstSlot(handle);
+            while (slots[slot].handle != M1OrientationDeviceHandleNone && slots[slot].handle != handle) {
+                slot = (slot + 1) & mask;
+            }
+            if (slots[slot].handle == M1OrientationDeviceHandleNone) {
+                slots[slot] = { handle, (int)i };
+            }
+        }
+    }
+
+    // Position of the device with `handle`, -1 if it isn't in the list
+    int find(M1OrientationDeviceHandle handle) const {
+        if (slots.empty() || handle == M1OrientationDeviceHandleNone) {
+            return -1;
+        }
+        for (std::size_t slot = getFirstSlot(handle); slots[slot].handle != M1OrientationDeviceHandleNone; slot = (slot + 1) & mask) {
+            if (slots[slot].handle == handle) {
+                return slots[slot].index;
+            }
+        }
+        return -1;
+    }
+
+    void swap(M1OrientationDeviceIndex& other) {
+        slots.swap(other.slots);
+        std::swap(mask, other.mask);
+    }
+
+private:
+    struct Slot {
+        M1OrientationDeviceHandle handle = M1OrientationDeviceHandleNone;
+        int index = -1;
+    };
+    std::vector<Slot> slots;
+    std::size_t mask = 0;
+
+    std::size_t getFirstSlot(M1OrientationDeviceHandle handle) const {
+        return (std::size_t)(((std::uint64_t)handle * 0x9e3779b97f4a7c15ull) >> 32) & mask;
+    }
 };
+
+// Appends the events turning `previous` into `current` to `events`, matching devices by handle
+// through the lists' indexes. O(previous + current) without allocating once `events` has grown,
+// order changes alone produce no events.
+void M1OrientationDiffDeviceLists(const std::vector<M1OrientationDeviceInfo>& previous, const M1OrientationDeviceIndex& previousIndex,
+                                  const std::vector<M1OrientationDeviceInfo>& current, const M1OrientationDeviceIndex& currentIndex,
+                                  std::vector<M1OrientationDeviceEvent>& events);
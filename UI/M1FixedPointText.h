@@ -0,0 +1,87 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+// Fixed-point text for live numeric readouts (e.g. the YPR values in M1OrientationClientWindow).
+// The value is quantized to `Decimals` digits and written with std::to_chars into an inline
+// buffer, so updating it never allocates and the text is only rebuilt when the quantized value
+// changes. Negative zero is printed as "0.00".
+template <int Decimals = 2>
+class M1FixedPointText {
+public:
+    static_assert(Decimals >= 0 && Decimals <= 9, "M1FixedPointText supports up to 9 decimals");
+
+    M1FixedPointText() {
+        format(0);
+    }
+
+    explicit M1FixedPointText(double value) {
+        set(value);
+    }
+
+    // Returns true if the displayed text changed
+    bool set(double value) {
+        if (!std::isfinite(value)) {
+            value = 0;
+        }
+        long long quantized = std::llround(value * scale());
+        if (quantized == current) {
+            return false;
+        }
+        format(quantized);
+        return true;
+    }
+
+    const char* c_str() const { return buffer; }
+    std::size_t size() const { return length; }
+    std::string str() const { return std::string(buffer, length); }
+    long long getQuantized() const { return current; }
+
+    bool operator==(const std::string& text) const { return text.size() == length && text.compare(0, length, buffer, length) == 0; }
+    bool operator!=(const std::string& text) const { return !(*this == text); }
+
+private:
+    // sign + 19 integer digits + point + decimals + terminator
+    char buffer[32];
+    std::size_t length = 0;
+    long long current = 0;
+
+    static constexpr long long scale() {
+        long long result = 1;
+        for (int i = 0; i < Decimals; i++) {
+            result *= 10;
+        }
+        return result;
+    }
+
+    void format(long long quantized) {
+        current = quantized;
+        unsigned long long magnitude = quantized < 0 ? 0ull - (unsigned long long)quantized : (unsigned long long)quantized;
+        unsigned long long integerPart = magnitude / (unsigned long long)scale();
+        unsigned long long fractionPart = magnitude % (unsigned long long)scale();
+
+        char* out = buffer;
+        char* end = buffer + sizeof(buffer) - 1;
+        if (quantized < 0) {
+            *out++ = '-';
+        }
+        out = std::to_chars(out, end, integerPart).ptr;
+        if (Decimals > 0) {
+            *out++ = '.';
+            // zero-pad the fraction to exactly `Decimals` digits
+            char digits[Decimals > 0 ? Decimals : 1];
+            for (int i = Decimals - 1; i >= 0; i--) {
+                digits[i] = (char)('0' + fractionPart % 10);
+                fractionPart /= 10;
+            }
+            for (int i = 0; i < Decimals; i++) {
+                *out++ = digits[i];
+            }
+        }
+        *out = '\0';
+        length = (std::size_t)(out - buffer);
+    }
+};
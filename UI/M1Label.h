@@ -2,6 +2,8 @@
 
 #include "MurkaView.h"
 #include "MurkaBasicWidgets.h"
+#include "M1FixedPointText.h"
+#include "M1TextLayoutCache.h"
 
 using namespace murka;
 
@@ -9,10 +11,7 @@ class M1Label : public murka::View<M1Label> {
 public:
     void internalDraw(Murka & m) {
         
-        auto font = m.getCurrentFont();
-        if (customFont) {
-            font = font;
-        }
+        FontObject* labelFont = customFont ? font : m.getCurrentFont();
         
         bool hovered = isHovered();
         
@@ -63,19 +62,19 @@ public:
         
         if (labelVerticalCentering) {
             // add to the labelPadding_y the text height halved subtracted from the height halved
-            label_y_center = shape.size.y/2 - font->getStringBoundingBox(label, 0, 0).height/2;
+            label_y_center = shape.size.y/2 - getLabelBox(labelFont).height/2;
         }
         
         if (alignment == TEXT_LEFT) {
-            font->drawString(label, labelPadding_x, labelPadding_y + label_y_center);
+            labelFont->drawString(label, labelPadding_x, labelPadding_y + label_y_center);
         }
         if (alignment == TEXT_CENTER) {
-            float textX = (shape.size.x / 2) - (font->getStringBoundingBox(label, 0, 0).width / 2);
-            font->drawString(label, textX, labelPadding_y + label_y_center);
+            float textX = (shape.size.x / 2) - (getLabelBox(labelFont).width / 2);
+            labelFont->drawString(label, textX, labelPadding_y + label_y_center);
         }
         if (alignment == TEXT_RIGHT) {
-            float textX = (shape.size.x - labelPadding_x) - font->getStringBoundingBox(label, 0, 0).width;
-            font->drawString(label, textX, labelPadding_y + label_y_center);
+            float textX = (shape.size.x - labelPadding_x) - getLabelBox(labelFont).width;
+            labelFont->drawString(label, textX, labelPadding_y + label_y_center);
         }
     }
     
@@ -92,8 +91,29 @@ public:
         return *this;
     }
     
-    M1Label& withText(std::string text) {
-        label = text;
+    // Only touch the stored label when the text actually changes
+    M1Label& withText(const std::string& text) {
+        if (label != text) {
+            label = text;
+            labelBoxValid = false;
+        }
+        return *this;
+    }
+    
+    M1Label& withText(const char* text) {
+        if (label != text) {
+            label = text;
+            labelBoxValid = false;
+        }
+        return *this;
+    }
+    
+    template <int Decimals>
+    M1Label& withText(const M1FixedPointText<Decimals>& text) {
+        if (text != label) {
+            label.assign(text.c_str(), text.size());
+            labelBoxValid = false;
+        }
         return *this;
     }
     
@@ -148,6 +168,19 @@ public:
         return *this;
     }
     
+    // Measurement cache of the window drawing this label, measured uncached without one
+    M1Label& withTextLayoutCache(M1TextLayoutCache* cache) {
+        textLayoutCache = cache;
+        return *this;
+    }
+    
+    // Draws with `labelFont` instead of Murka's current font
+    M1Label& withFont(FontObject* labelFont) {
+        customFont = labelFont != nullptr;
+        font = labelFont;
+        return *this;
+    }
+    
     std::function<void()> onClickCallback = []() {};
     
     bool bgFill = false;
@@ -162,7 +195,7 @@ public:
     MurkaColor backgroundColorUnhovered = { 0., 0., 0., 0. };
     bool backgroundColorHoverEnable = false;
 
-    FontObject* font;
+    FontObject* font = nullptr;
 
     bool customColor = false;
     bool customFont = false;
@@ -175,4 +208,21 @@ public:
 	bool result;
 
 	virtual bool wantsClicks() override { return false; } // override this if you want to signal that you don't want clicks
+
+private:
+    M1TextLayoutCache* textLayoutCache = nullptr;
+
+    // Measured label, re-measured only when the text or the font changes
+    FontObject* labelBoxFont = nullptr;
+    juceFontStash::Rectangle labelBox;
+    bool labelBoxValid = false;
+
+    const juceFontStash::Rectangle& getLabelBox(FontObject* labelFont) {
+        if (!labelBoxValid || labelFont != labelBoxFont) {
+            labelBox = M1TextLayoutCache::measure(textLayoutCache, labelFont, label);
+            labelBoxFont = labelFont;
+            labelBoxValid = true;
+        }
+        return labelBox;
+    }
 };
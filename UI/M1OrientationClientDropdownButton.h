@@ -7,6 +7,7 @@
 #include "MurkaAssets.h"
 #include "MurkaLinearLayoutGenerator.h"
 #include "MurkaBasicWidgets.h"
+#include "M1TextLayoutCache.h"
 
 using namespace murka;
 
@@ -33,10 +34,16 @@ public:
         }
         
         m.setColor(labelColor);
-        m.setFontFromRawData(PLUGIN_FONT, BINARYDATA_FONT, BINARYDATA_FONT_SIZE, (int)fontSize);
+        FontObject* font = M1TextLayoutCache::getFont(textLayoutCache, m, PLUGIN_FONT, BINARYDATA_FONT, BINARYDATA_FONT_SIZE, (int)fontSize);
         // interior text
-        juceFontStash::Rectangle label_box = m.getCurrentFont()->getStringBoundingBox(label, 0, 0); // used to find size of text
-        m.prepare<murka::Label>({labelPadding_x, shape.size.y/2 - label_box.height/2, shape.size.x - labelPadding_x, shape.size.y}).withAlignment(textAlignment).text(label).draw();
+        if (!labelBoxValid || font != labelBoxFont) {
+            label_box = M1TextLayoutCache::measure(textLayoutCache, font, label); // used to find size of text
+            labelBoxFont = font;
+            labelBoxValid = true;
+        }
+        // Drawn with the label font itself, Murka's current font may be another size
+        float textX = labelPadding_x + M1TextLayoutCache::alignText(textAlignment, shape.size.x - labelPadding_x, label_box.width);
+        font->drawString(label, textX, shape.size.y/2 - label_box.height/2);
         
         pressed = false;
         if ((isHovered()) && (mouseDownPressed(0))) {
@@ -58,8 +65,11 @@ public:
         return pressed;
     }
     
-    M1OrientationClientDropdownButton & withLabel(std::string label_) {
-        label = label_;
+    M1OrientationClientDropdownButton & withLabel(const std::string& label_) {
+        if (label != label_) {
+            label = label_;
+            labelBoxValid = false;
+        }
         return *this;
     }
     
@@ -92,4 +102,15 @@ public:
         drawTriangle = triangle;
         return *this;
     }
+    
+    M1OrientationClientDropdownButton & withTextLayoutCache(M1TextLayoutCache* cache) {
+        textLayoutCache = cache;
+        return *this;
+    }
+
+private:
+    M1TextLayoutCache* textLayoutCache = nullptr;
+    FontObject* labelBoxFont = nullptr;
+    juceFontStash::Rectangle label_box;
+    bool labelBoxValid = false;
 };
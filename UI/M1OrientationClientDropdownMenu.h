@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+
 #include "MurkaTypes.h"
 #include "MurkaContext.h"
 #include "MurkaView.h"
@@ -7,6 +10,7 @@
 #include "MurkaAssets.h"
 #include "MurkaLinearLayoutGenerator.h"
 #include "MurkaBasicWidgets.h"
+#include "M1TextLayoutCache.h"
 
 #if !defined(DEFAULT_FONT_SIZE)
 #define DEFAULT_FONT_SIZE 10
@@ -60,8 +64,14 @@ public:
             bool coarseHoveredScrollbar = (drawScrollbar ? mousePosition().x > shape.size.x - scrollbarWidth : false);
             
             // Drawing the options
+            
+            FontObject* font = M1TextLayoutCache::getFont(textLayoutCache, m, PLUGIN_FONT, BINARYDATA_FONT, BINARYDATA_FONT_SIZE, fontSize);
 
-            for (int i = 0; i < options.size(); i++) {
+            // Only the rows intersecting the visible area are walked and drawn
+            int firstVisibleOption = std::max(0, (int)(scrollbarOffsetInPixels / optionHeight));
+            int lastVisibleOption = std::min((int)options.size(), (int)std::ceil((scrollbarOffsetInPixels + shape.size.y) / optionHeight));
+
+            for (int i = firstVisibleOption; i < lastVisibleOption; i++) {
                 
                 bool hoveredAnOption = (mousePosition().y > i * optionHeight - scrollbarOffsetInPixels) && (mousePosition().y < (i + 1) * optionHeight - scrollbarOffsetInPixels) && inside();
                 
@@ -72,9 +82,8 @@ public:
                     m.setColor(outlineColor);
                     m.drawRectangle(1, i * optionHeight - scrollbarOffsetInPixels, shape.size.x - 2, optionHeight);
                     m.setColor(highlightLabelColor);
-                    m.setFontFromRawData(PLUGIN_FONT, BINARYDATA_FONT, BINARYDATA_FONT_SIZE, fontSize);
-                    juceFontStash::Rectangle label_box = m.getCurrentFont()->getStringBoundingBox(options[i], 0, 0); // used to find size of text
-                    m.prepare<murka::Label>({labelPadding_x, (optionHeight * i) + optionHeight/2 - label_box.height/2 - scrollbarOffsetInPixels, shape.size.x - labelPadding_x, optionHeight}).text(options[i]).withAlignment(textAlignment).draw();
+                    juceFontStash::Rectangle label_box = M1TextLayoutCache::measure(textLayoutCache, font, options[i]); // used to find size of text
+                    drawOption(font, i, label_box);
                     
                     if (closingMode == modeMouseDown) {
                         if (mouseDownPressed(0)) {
@@ -99,19 +108,18 @@ public:
                     if (i == selectedOption) {
                         m.setColor(selectedLabelColor);
                     }
-                    m.setFontFromRawData(PLUGIN_FONT, BINARYDATA_FONT, BINARYDATA_FONT_SIZE, fontSize);
-                    juceFontStash::Rectangle label_box = m.getCurrentFont()->getStringBoundingBox(options[i], 0, 0); // used to find size of text
-                    m.prepare<murka::Label>({labelPadding_x, (optionHeight * i) + optionHeight/2 - label_box.height/2 - scrollbarOffsetInPixels, shape.size.x - labelPadding_x, optionHeight}).text(options[i]).withAlignment(textAlignment).draw();
+                    juceFontStash::Rectangle label_box = M1TextLayoutCache::measure(textLayoutCache, font, options[i]); // used to find size of text
+                    drawOption(font, i, label_box);
                 }
-                
-                // Closing if pressed/released outside of the menu
-                if (!inside() && !hoveredAnything && !holdingScrollbar && opened) {
-                    if ((closingMode == modeMouseDown) && (mouseDownPressed(0))) {
-                        close(false);
-                    }
-                    if ((closingMode == modeMouseUp) && (mouseReleased(0))) {
-                        close(false);
-                    }
+            }
+            
+            // Closing if pressed/released outside of the menu
+            if (!options.empty() && !inside() && !hoveredAnything && !holdingScrollbar && opened) {
+                if ((closingMode == modeMouseDown) && (mouseDownPressed(0))) {
+                    close(false);
+                }
+                if ((closingMode == modeMouseUp) && (mouseReleased(0))) {
+                    close(false);
                 }
             }
             
@@ -166,6 +174,7 @@ public:
     bool opened = false;
     int selectedOption = 0;
     std::vector<std::string> options;
+    std::vector<std::size_t> optionIds; // stable identity per row (e.g. device handle), parallel to `options`
     int* dataToControl = nullptr;
     
     int optionHeight = 30;
@@ -221,14 +230,70 @@ public:
         return *this;
     }
     
-    M1OrientationClientDropdownMenu & withOptions(std::vector<std::string> options_) {
-        options = options_;
+    // Rows are diffed against the current ones so unchanged rows are left untouched, and the
+    // selection follows its row id across reorders. Without ids the option text is the identity.
+    M1OrientationClientDropdownMenu & withOptions(const std::vector<std::string>& options_, const std::vector<std::size_t>& optionIds_ = {}) {
+        std::size_t selectedId = getSelectedOptionId();
+        bool hadSelection = selectedOption >= 0 && selectedOption < (int)options.size();
+
+        options.resize(options_.size());
+        optionIds.resize(options_.size());
+        for (std::size_t i = 0; i < options_.size(); i++) {
+            if (options[i] != options_[i]) {
+                options[i] = options_[i];
+            }
+            optionIds[i] = i < optionIds_.size() ? optionIds_[i] : std::hash<std::string>()(options_[i]);
+        }
+
+        if (hadSelection) {
+            int index = findOptionWithId(selectedId);
+            if (index >= 0) {
+                selectedOption = index;
+            }
+        }
         return *this;
     }
     
+    // Selects the row with `optionId`, the first row when there is none
+    M1OrientationClientDropdownMenu & withSelectedOptionId(std::size_t optionId) {
+        int index = findOptionWithId(optionId);
+        selectedOption = index >= 0 ? index : 0;
+        return *this;
+    }
+    
+    int findOptionWithId(std::size_t optionId) const {
+        for (std::size_t i = 0; i < optionIds.size(); i++) {
+            if (optionIds[i] == optionId) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+    
+    std::size_t getSelectedOptionId() const {
+        if (selectedOption >= 0 && selectedOption < (int)optionIds.size()) {
+            return optionIds[selectedOption];
+        }
+        return 0;
+    }
+
+    
     M1OrientationClientDropdownMenu & withTriggerButtonPlacedAt(MurkaShape shape) {
         triggerButtonShape = shape;
         return *this;
     }
     
+    M1OrientationClientDropdownMenu & withTextLayoutCache(M1TextLayoutCache* cache) {
+        textLayoutCache = cache;
+        return *this;
+    }
+
+private:
+    M1TextLayoutCache* textLayoutCache = nullptr;
+
+    // Drawn with the option font itself, Murka's current font may be another size
+    void drawOption(FontObject* font, int option, const juceFontStash::Rectangle& label_box) {
+        float textX = labelPadding_x + M1TextLayoutCache::alignText(textAlignment, shape.size.x - labelPadding_x, label_box.width);
+        font->drawString(options[option], textX, (optionHeight * option) + optionHeight/2 - label_box.height/2 - scrollbarOffsetInPixels);
+    }
 };
@@ -1,9 +1,9 @@
 #pragma once
 
-#include <sstream>
 #include "MurkaView.h"
 #include "TextField.h"
 #include "MurkaBasicWidgets.h"
+#include "M1FixedPointText.h"
 #include "M1SwitchableIconButton.h"
 #include "M1OrientationClientDropdownButton.h"
 #include "M1OrientationClientDropdownMenu.h"
@@ -17,6 +17,7 @@ using namespace murka;
 struct M1OrientationClientWindowDeviceSlot {
     std::string icon;
     std::string deviceName;
+    M1OrientationDeviceHandle deviceHandle = M1OrientationDeviceHandleNone; // stable row identity, resolved from the client's devices when unset
     bool highlighted = false;
     int index = 0;
     std::function<void(int)> onClickCallback = [](int){};
@@ -29,66 +30,28 @@ public:
     }
 
 	std::string formatFloatWithLeadingZeros(float value) {
-		std::ostringstream oss;
-        oss.precision(2); // forces float to only use 2 floating digits
-		oss << std::fixed << std::setfill('0') << std::setw(2) << value;
-		return oss.str();
+		return M1FixedPointText<2>(value).str(); // forces float to only use 2 floating digits
 	}
     
     void internalDraw(Murka & m) {
-        // Updating the state from the client
-        deviceSelectedOption = "";
-
+        // Updating the state from the client, only re-reading what changed since the last frame
         if (orientationClient != nullptr) {
-            isConnected = orientationClient->isConnectedToDevice();
-            
-            if (isConnected) {
-                deviceSelectedOption = orientationClient->getCurrentDevice().getDeviceName();
-            } else {
-                deviceSelectedOption = "<SELECT DEVICE>";
+            juce::uint32 stateGeneration = orientationClient->getStateGeneration();
+            if (!hasCachedState || stateGeneration != cachedStateGeneration) {
+                cachedStateGeneration = stateGeneration;
+                hasCachedState = true;
+                updateClientState();
+            }
+
+            juce::uint32 orientationVersion = orientationClient->getOrientationVersion();
+            if (hasCurrentDevice && (!hasCachedOrientation || orientationVersion != cachedOrientationVersion)) {
+                cachedOrientationVersion = orientationVersion;
+                hasCachedOrientation = true;
+                Mach1::Float3 ypr = orientationClient->getOrientation().GetGlobalRotationAsEulerDegrees();
+                updateDisplayedValue(0, ypr.GetYaw());
+                updateDisplayedValue(1, ypr.GetPitch());
+                updateDisplayedValue(2, ypr.GetRoll());
             }
-            
-            showOscSettings = (orientationClient->getCurrentDevice().getDeviceType() == M1OrientationManagerDeviceTypeOSC);
-            showSWSettings = orientationClient->getCurrentDevice().getDeviceName().find("Supperware HT IMU") != std::string::npos;
-            oscSettingsChangedCallback = [&](int requested_osc_port, std::string requested_osc_msg_address) {
-                orientationClient->command_setAdditionalDeviceSettings("osc_add="+requested_osc_msg_address);
-                orientationClient->command_setAdditionalDeviceSettings("osc_p="+std::to_string(requested_osc_port));
-            };
-            supperwareSettingsChangedCallback = [&](bool isRightEarChirality) {
-                std::string chir_cmd;
-                if (isRightEarChirality) {
-                    chir_cmd = "1";
-                } else {
-                    chir_cmd = "0";
-                }
-                orientationClient->command_setAdditionalDeviceSettings("sw_chir="+chir_cmd);
-            };
-            disconnectClickedCallback = [&]() {
-                orientationClient->command_disconnect();
-            };
-            recenterClickedCallback = [&]() {
-                orientationClient->command_recenter();
-            };
-            yprSwitchesClickedCallback = [&](int whichone) {
-                if (whichone == 0)
-                    // yaw clicked
-                    orientationClient->command_setTrackingYawEnabled(!orientationClient->getTrackingYawEnabled());
-                if (whichone == 1)
-                    // pitch clicked
-                    orientationClient->command_setTrackingPitchEnabled(!orientationClient->getTrackingPitchEnabled());
-                if (whichone == 2)
-                    // roll clicked
-                    orientationClient->command_setTrackingRollEnabled(!orientationClient->getTrackingRollEnabled());
-                if (whichone == 3)
-                    // yaw invert clicked
-                    orientationClient->command_setTrackingYawInverted(!orientationClient->getTrackingYawInverted());
-                if (whichone == 4)
-                    // pitch invert clicked
-                    orientationClient->command_setTrackingPitchInverted(!orientationClient->getTrackingPitchInverted());
-                if (whichone == 5)
-                    // roll invert clicked
-                    orientationClient->command_setTrackingRollInverted(!orientationClient->getTrackingRollInverted());
-            };
         }
         
         if (!inside() && !areInteractiveChildrenHovered() && mouseDownPressed(0)) {
@@ -104,9 +67,9 @@ public:
         } else {
             m.setColor(ENABLED_PARAM); // disconnected white
         }
-        m.setFontFromRawData(PLUGIN_FONT, BINARYDATA_FONT, BINARYDATA_FONT_SIZE, DEFAULT_FONT_SIZE-1);
+        FontObject* labelFont = textLayoutCache.getFont(m, PLUGIN_FONT, BINARYDATA_FONT, BINARYDATA_FONT_SIZE, DEFAULT_FONT_SIZE-1);
 
-        m.prepare<M1Label>(MurkaShape(m.getSize().width()/2 - 75, 0, 150, 30)).withText("CONNECTED DEVICE").withTextAlignment(TEXT_CENTER).draw();
+        m.prepare<M1Label>(MurkaShape(m.getSize().width()/2 - 75, 0, 150, 30)).withText("CONNECTED DEVICE").withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache).draw();
         
         m.drawLine(7, 7, m.getSize().width()/2 - 75, 7);
         m.drawLine(m.getSize().width()/2 + 75, 7, m.getSize().width() - 7, 7);
@@ -121,7 +84,7 @@ public:
             m.prepare<M1Label>(MurkaShape(m.getSize().width()/3 * 0,
                                           additionalSettingsOffsetY,
                                           m.getSize().width()/3, 30))
-            .withText((orientationClient->getTrackingYawInverted()) ? "-YAW" : "+YAW").withTextAlignment(TEXT_CENTER)
+            .withText(trackingYawInverted ? "-YAW" : "+YAW").withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache)
             .withOnClickCallback([&](){
                 orientationClient->command_setTrackingYawInverted(!orientationClient->getTrackingYawInverted());
             })
@@ -129,7 +92,7 @@ public:
             m.prepare<M1Label>(MurkaShape(m.getSize().width()/3 * 1 - 2,
                                           additionalSettingsOffsetY,
                                           m.getSize().width()/3, 30))
-            .withText((orientationClient->getTrackingPitchInverted()) ? "-PITCH" : "+PITCH").withTextAlignment(TEXT_CENTER)
+            .withText(trackingPitchInverted ? "-PITCH" : "+PITCH").withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache)
             .withOnClickCallback([&](){
                 orientationClient->command_setTrackingPitchInverted(!orientationClient->getTrackingPitchInverted());
             })
@@ -137,20 +100,17 @@ public:
             m.prepare<M1Label>(MurkaShape(m.getSize().width()/3 * 2 - 7,
                                           additionalSettingsOffsetY,
                                           m.getSize().width()/3, 30))
-            .withText((orientationClient->getTrackingRollInverted()) ? "-ROLL" : "+ROLL").withTextAlignment(TEXT_CENTER)
+            .withText(trackingRollInverted ? "-ROLL" : "+ROLL").withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache)
             .withOnClickCallback([&](){
                 orientationClient->command_setTrackingRollInverted(!orientationClient->getTrackingRollInverted());
             })
             .draw();
 
             // Yaw value display & Enable button
-            std::stringstream ytmp;
-            ytmp << std::fixed << std::setprecision(2) << orientationClient->getOrientation().GetGlobalRotationAsEulerDegrees().GetYaw() + 0.0;
-            std::string yawValue = ytmp.str();
             m.prepare<M1Label>(MurkaShape(m.getSize().width()/3 * 0 + 6,
                                           additionalSettingsOffsetY + 22,
                                           m.getSize().width()/3 - 6, 30))
-            .withText((orientationClient->getCurrentDevice().getDeviceType() != M1OrientationManagerDeviceTypeNone) ? yawValue : "0.00").withTextAlignment(TEXT_CENTER).withVerticalTextCentering(true)
+            .withText(displayedValues[0]).withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache).withVerticalTextCentering(true)
             .withBackgroundFill(MurkaColor(DISABLED_PARAM), MurkaColor(BACKGROUND_GREY))
             .withStrokeBorder(MurkaColor(ORIENTATION_ACTIVE_COLOR))
             .withOnClickCallback([&](){
@@ -159,13 +119,10 @@ public:
             .draw();
 
             // Pitch value display & Enable button
-            std::stringstream ptmp;
-            ptmp << std::fixed << std::setprecision(2) << orientationClient->getOrientation().GetGlobalRotationAsEulerDegrees().GetPitch() + 0.0;
-            std::string pitchValue = ptmp.str();
             m.prepare<M1Label>(MurkaShape(m.getSize().width()/3 * 1 + 4,
                                           additionalSettingsOffsetY + 22,
                                           m.getSize().width()/3 - 8, 30))
-            .withText((orientationClient->getCurrentDevice().getDeviceType() != M1OrientationManagerDeviceTypeNone) ? pitchValue : "0.00").withTextAlignment(TEXT_CENTER).withVerticalTextCentering(true)
+            .withText(displayedValues[1]).withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache).withVerticalTextCentering(true)
             .withBackgroundFill(MurkaColor(DISABLED_PARAM), MurkaColor(BACKGROUND_GREY))
             .withStrokeBorder(MurkaColor(ORIENTATION_ACTIVE_COLOR))
             .withOnClickCallback([&](){
@@ -174,13 +131,10 @@ public:
             .draw();
 
             // Roll value display & Enable button
-            std::stringstream rtmp;
-            rtmp << std::fixed << std::setprecision(2) << orientationClient->getOrientation().GetGlobalRotationAsEulerDegrees().GetRoll() + 0.0;
-            std::string rollValue = rtmp.str();
             m.prepare<M1Label>(MurkaShape(m.getSize().width()/3 * 2 + 0,
                                           additionalSettingsOffsetY + 22,
                                           m.getSize().width()/3 - 6, 30))
-            .withText((orientationClient->getCurrentDevice().getDeviceType() != M1OrientationManagerDeviceTypeNone) ? rollValue : "0.00").withTextAlignment(TEXT_CENTER).withVerticalTextCentering(true)
+            .withText(displayedValues[2]).withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache).withVerticalTextCentering(true)
             .withBackgroundFill(MurkaColor(DISABLED_PARAM), MurkaColor(BACKGROUND_GREY))
             .withStrokeBorder(MurkaColor(ORIENTATION_ACTIVE_COLOR))
             .withOnClickCallback([&](){
@@ -193,7 +147,7 @@ public:
             m.prepare<M1Label>(MurkaShape(m.getSize().width()/2 * 0 + 6,
                                           additionalSettingsOffsetY + 60,
                                           m.getSize().width()/2 - 8, 30))
-            .withText("RECENTER").withTextAlignment(TEXT_CENTER).withVerticalTextCentering(true)
+            .withText("RECENTER").withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache).withVerticalTextCentering(true)
             .withOnClickFlash()
             .withBackgroundFill(MurkaColor(DISABLED_PARAM), MurkaColor(BACKGROUND_GREY))
             .withStrokeBorder(MurkaColor(ORIENTATION_ACTIVE_COLOR))
@@ -207,7 +161,7 @@ public:
                                           m.getSize().width()/2 - 8, 30))
             .withBackgroundFill(MurkaColor(DISABLED_PARAM), MurkaColor(BACKGROUND_GREY))
             .withOnClickFlash()
-            .withText("DISCONNECT").withTextAlignment(TEXT_CENTER).withVerticalTextCentering(true)
+            .withText("DISCONNECT").withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache).withVerticalTextCentering(true)
             .withStrokeBorder(MurkaColor(ORIENTATION_ACTIVE_COLOR))
             .withOnClickCallback([&](){
                 orientationClient->command_disconnect();
@@ -216,11 +170,11 @@ public:
             
             float additionalOptionY = 80;
 
-            if (deviceSelectedOption == "Supperware HT IMU" || deviceSelectedOption == "SUPPERWARE HT IMU") {
+            if (showSupperwareOptions) {
                 // Chirality button
                 m.prepare<M1Label>(MurkaShape(6, additionalOptionY, shape.size.x  - 8, 30))
                 .withBackgroundFill(MurkaColor(DISABLED_PARAM), MurkaColor(BACKGROUND_GREY))
-                .withText(supperwareChirality).withTextAlignment(TEXT_CENTER).withVerticalTextOffset(3)
+                .withText(supperwareChirality).withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache).withVerticalTextOffset(3)
                 .withOnClickCallback([&](){
                     if (supperwareChirality == "USB ON THE LEFT") {
                         supperwareChirality = "USB ON THE RIGHT";
@@ -236,7 +190,7 @@ public:
                 // Calibrate button
                 m.prepare<M1Label>(MurkaShape(6, additionalOptionY + 30, shape.size.x  - 8, 30))
                 .withBackgroundFill(MurkaColor(DISABLED_PARAM), MurkaColor(BACKGROUND_GREY))
-                .withText("CALIBRATE").withTextAlignment(TEXT_CENTER).withVerticalTextOffset(3)
+                .withText("CALIBRATE").withTextAlignment(TEXT_CENTER).withFont(labelFont).withTextLayoutCache(&textLayoutCache).withVerticalTextOffset(3)
                 .withOnClickCallback([&](){
                     
                 })
@@ -245,7 +199,7 @@ public:
                 .draw();
             }
             
-            if (deviceSelectedOption == "OSC Input" || deviceSelectedOption == "OSC Device") {
+            if (showOscOptions) {
                 // INPUT MSG ADDRESS PATTERN TEXTFIELD
                 auto& msg_address_pattern_field = m.prepare<murka::TextField>({8, additionalOptionY, shape.size.x * 0.7 - 10, 30}).onlyAllowNumbers(false).controlling(&requested_osc_msg_address);
                 msg_address_pattern_field.drawBounds = false;
@@ -281,27 +235,21 @@ public:
             }
         }
         
-        std::vector<std::string> deviceListStrings;
-        if (deviceSlots.size() > 0) {
-            deviceListStrings.push_back("<SELECT DEVICE>");
-        } else {
-            deviceListStrings.push_back("<NOT AVAILABLE>");
-        }
-        
-        int selectedOptionInDeviceList = 0;
-        for (int i = 0; i < deviceSlots.size(); i++) {
-            deviceListStrings.push_back(deviceSlots[i].deviceName);
-            
-            if (isConnected) {
-                if (orientationClient->getCurrentDevice().getDeviceName() == deviceSlots[i].deviceName) {
-                    selectedOptionInDeviceList = i + 1; // cause 0 is "SELECTE DEVICE"
-                }
-            }
+        if (deviceListDirty) {
+            rebuildDeviceList();
         }
 
         float deviceDropdownY = 28;
         
-        auto& deviceDropdown = m.prepare<M1OrientationClientDropdownMenu>({7, deviceDropdownY, shape.size.x - 14, 120}).withOptions(deviceListStrings);
+        auto& deviceDropdown = m.prepare<M1OrientationClientDropdownMenu>({7, deviceDropdownY, shape.size.x - 14, 120});
+        if (deviceListDirty || &deviceDropdown != deviceDropdownWithOptions) {
+            // Only hand the options and the selection over when they changed, the dropdown diffs
+            // the rows by id and keeps the user's pick in between
+            deviceDropdown.withOptions(deviceListStrings, deviceListIds);
+            deviceDropdown.withSelectedOptionId(selectedDeviceListId);
+            deviceDropdownWithOptions = &deviceDropdown;
+            deviceListDirty = false;
+        }
         deviceDropdown.withLabelColor(MurkaColor(LABEL_TEXT_COLOR));
         deviceDropdown.withSelectedLabelColor(MurkaColor(ORIENTATION_ACTIVE_COLOR));
         deviceDropdown.withHighlightLabelColor(MurkaColor(BACKGROUND_GREY));
@@ -309,7 +257,7 @@ public:
         deviceDropdown.fontSize = DEFAULT_FONT_SIZE;
         deviceDropdown.optionHeight = 40;
         deviceDropdown.labelPadding_x = 5;
-        deviceDropdown.selectedOption = selectedOptionInDeviceList;
+        deviceDropdown.withTextLayoutCache(&textLayoutCache);
         
         if (!showDeviceSelectionDropdown) {
             MurkaShape dropdownInitShape = MurkaShape(7, deviceDropdownY, shape.size.x - 14, 40);
@@ -321,7 +269,7 @@ public:
             // `withOutlineColor()` sets the triangle
             // TODO: Make isConnected test include checking the device name
             auto& dropdownInit = m.prepare<M1OrientationClientDropdownButton>(dropdownInitShape).withLabel(deviceSelectedOption).withLabelColor(isConnected ? MurkaColor(ORIENTATION_ACTIVE_COLOR) : MurkaColor(LABEL_TEXT_COLOR)).withOutline(false).withOutlineColor(isConnected ? MurkaColor(ORIENTATION_ACTIVE_COLOR) : MurkaColor(ENABLED_PARAM)).withBackgroundColor(MurkaColor(BACKGROUND_GREY))
-                .withTriangle(true);
+                .withTriangle(true).withTextLayoutCache(&textLayoutCache);
             dropdownInit.textAlignment = TEXT_LEFT;
             dropdownInit.fontSize = DEFAULT_FONT_SIZE;
             dropdownInit.labelPadding_x = 5;
@@ -336,12 +284,17 @@ public:
             if (deviceDropdown.changed || !deviceDropdown.opened) {
                 // UPDATING THE DEVICE PER SELECTED OPTION
                 
-                std::vector<M1OrientationDeviceInfo> sourceDevices = orientationClient->getDevices();
-                bool foundDevice = false;
-                for (int i = 0; i < sourceDevices.size(); i++) {
-                    if (sourceDevices[i].getDeviceName() == deviceListStrings[deviceDropdown.selectedOption]) {
-                        orientationClient->command_startTrackingUsingDevice(sourceDevices[i]);
-                        foundDevice = true;
+                // Rows carry the device handle when the slots provide one, resolved in O(1) by the client
+                bool foundDevice = orientationClient->command_startTrackingUsingDevice((M1OrientationDeviceHandle)deviceDropdown.getSelectedOptionId());
+                if (!foundDevice && deviceDropdown.selectedOption > 0) {
+                    std::vector<M1OrientationDeviceInfo> sourceDevices = orientationClient->getDevices();
+                    for (int i = 0; i < sourceDevices.size(); i++) {
+                        if (sourceDevices[i].getDeviceName() == deviceDropdown.options[deviceDropdown.selectedOption]) {
+                            // Same name on several devices, only start the first one
+                            orientationClient->command_startTrackingUsingDevice(sourceDevices[i]);
+                            foundDevice = true;
+                            break;
+                        }
                     }
                 }
                 
@@ -368,12 +321,26 @@ public:
     juce::int64 millisWhenRefreshingStarted = 0;
 
     M1OrientationClientWindow& withOrientationClient(M1OrientationClient& client) {
-        orientationClient = &client;
+        if (orientationClient != &client) {
+            orientationClient = &client;
+            hasCachedState = false;
+            hasCachedOrientation = false;
+            bindClientCallbacks();
+        }
         return *this;
     }
     
-    M1OrientationClientWindow& withDeviceSlots(std::vector<M1OrientationClientWindowDeviceSlot> slots) {
-        deviceSlots = slots;
+    M1OrientationClientWindow& withDeviceSlots(const std::vector<M1OrientationClientWindowDeviceSlot>& slots) {
+        // Called every frame, only mark the list dirty when the slots actually changed
+        bool slotsChanged = slots.size() != deviceSlots.size();
+        for (std::size_t i = 0; !slotsChanged && i < slots.size(); i++) {
+            slotsChanged = slots[i].deviceName != deviceSlots[i].deviceName || slots[i].deviceHandle != deviceSlots[i].deviceHandle
+                || slots[i].highlighted != deviceSlots[i].highlighted || slots[i].icon != deviceSlots[i].icon || slots[i].index != deviceSlots[i].index;
+        }
+        if (slotsChanged) {
+            deviceSlots = slots;
+            deviceListDirty = true;
+        }
         return *this;
     }
     
@@ -418,4 +385,160 @@ public:
     int requested_osc_port = 9901; // default value
     std::string requested_osc_msg_address = "/orientation"; // default value
     std::function<void(int, std::string)> oscSettingsChangedCallback;
+
+private:
+    // Fonts and text measurements of this window's Murka, shared by the widgets it draws
+    M1TextLayoutCache textLayoutCache;
+
+    // State derived from the client, rebuilt when its state generation / orientation version moves
+    juce::uint32 cachedStateGeneration = 0;
+    juce::uint32 cachedOrientationVersion = 0;
+    bool hasCachedState = false;
+    bool hasCachedOrientation = false;
+    bool hasCurrentDevice = false;
+    bool showSupperwareOptions = false;
+    bool showOscOptions = false;
+    bool trackingYawInverted = false;
+    bool trackingPitchInverted = false;
+    bool trackingRollInverted = false;
+    M1FixedPointText<2> displayedValues[3];
+
+    // Dropdown rows, rebuilt when the slots or the connected device change
+    bool deviceListDirty = true;
+    std::vector<std::string> deviceListStrings;
+    std::vector<std::size_t> deviceListIds;
+    std::size_t selectedDeviceListId = M1OrientationDeviceHandleNone;
+    M1OrientationDeviceHandle currentDeviceHandle = M1OrientationDeviceHandleNone;
+    std::vector<M1OrientationDeviceInfo> slotDevices;
+    M1OrientationClientDropdownMenu* deviceDropdownWithOptions = nullptr;
+
+    void rebuildDeviceList() {
+        deviceListStrings.clear();
+        deviceListIds.clear();
+        if (deviceSlots.size() > 0) {
+            deviceListStrings.push_back("<SELECT DEVICE>");
+        } else {
+            deviceListStrings.push_back("<NOT AVAILABLE>");
+        }
+        deviceListIds.push_back(M1OrientationDeviceHandleNone);
+
+        // Slots built without a handle get the one of the client's device they list
+        slotDevices.clear();
+        bool resolveHandles = orientationClient != nullptr && std::any_of(deviceSlots.begin(), deviceSlots.end(), [](const M1OrientationClientWindowDeviceSlot& slot) {
+            return slot.deviceHandle == M1OrientationDeviceHandleNone;
+        });
+        if (resolveHandles) {
+            slotDevices = orientationClient->getDevices();
+        }
+
+        selectedDeviceListId = M1OrientationDeviceHandleNone; // "<SELECT DEVICE>"
+        std::size_t selectedNameId = M1OrientationDeviceHandleNone;
+        for (int i = 0; i < deviceSlots.size(); i++) {
+            M1OrientationDeviceHandle handle = deviceSlots[i].deviceHandle;
+            if (handle == M1OrientationDeviceHandleNone) {
+                handle = findSlotDeviceHandle(deviceSlots[i]);
+            }
+            std::size_t id = handle != M1OrientationDeviceHandleNone ? handle : std::hash<std::string>()(deviceSlots[i].deviceName);
+            deviceListStrings.push_back(deviceSlots[i].deviceName);
+            deviceListIds.push_back(id);
+
+            if (isConnected) {
+                if (id == currentDeviceHandle) {
+                    selectedDeviceListId = id;
+                } else if (selectedNameId == M1OrientationDeviceHandleNone && deviceSelectedOption == deviceSlots[i].deviceName) {
+                    selectedNameId = id;
+                }
+            }
+        }
+        if (selectedDeviceListId == M1OrientationDeviceHandleNone) {
+            selectedDeviceListId = selectedNameId;
+        }
+        slotDevices.clear();
+    }
+
+    // The slot's device in `slotDevices`, at the slot's index or else the first with its name
+    M1OrientationDeviceHandle findSlotDeviceHandle(const M1OrientationClientWindowDeviceSlot& slot) const {
+        if (slot.index >= 0 && slot.index < (int)slotDevices.size() && slotDevices[slot.index].getDeviceName() == slot.deviceName) {
+            return slotDevices[slot.index].getDeviceHandle();
+        }
+        for (const M1OrientationDeviceInfo& device : slotDevices) {
+            if (device.getDeviceName() == slot.deviceName) {
+                return device.getDeviceHandle();
+            }
+        }
+        return M1OrientationDeviceHandleNone;
+    }
+
+    void updateClientState() {
+        M1OrientationDeviceInfo currentDevice = orientationClient->getCurrentDevice();
+        hasCurrentDevice = currentDevice.getDeviceType() != M1OrientationManagerDeviceTypeNone;
+        isConnected = hasCurrentDevice;
+        currentDeviceHandle = hasCurrentDevice ? currentDevice.getDeviceHandle() : M1OrientationDeviceHandleNone;
+        deviceSelectedOption = isConnected ? currentDevice.getDeviceName() : "<SELECT DEVICE>";
+
+        showOscSettings = currentDevice.getDeviceType() == M1OrientationManagerDeviceTypeOSC;
+        showSWSettings = currentDevice.getDeviceName().find("Supperware HT IMU") != std::string::npos;
+        showSupperwareOptions = deviceSelectedOption == "Supperware HT IMU" || deviceSelectedOption == "SUPPERWARE HT IMU";
+        showOscOptions = deviceSelectedOption == "OSC Input" || deviceSelectedOption == "OSC Device";
+
+        trackingYawInverted = orientationClient->getTrackingYawInverted();
+        trackingPitchInverted = orientationClient->getTrackingPitchInverted();
+        trackingRollInverted = orientationClient->getTrackingRollInverted();
+
+        if (!hasCurrentDevice) {
+            for (int i = 0; i < 3; i++) {
+                displayedValues[i].set(0);
+            }
+        }
+        // Force the values to be re-read for the new device
+        hasCachedOrientation = false;
+        deviceListDirty = true;
+    }
+
+    void updateDisplayedValue(int axis, float degrees) {
+        // Only regenerates the text when the displayed (2 decimals) value changes
+        displayedValues[axis].set(degrees);
+    }
+
+    void bindClientCallbacks() {
+        oscSettingsChangedCallback = [this](int requested_osc_port, std::string requested_osc_msg_address) {
+            orientationClient->command_setAdditionalDeviceSettings("osc_add="+requested_osc_msg_address);
+            orientationClient->command_setAdditionalDeviceSettings("osc_p="+std::to_string(requested_osc_port));
+        };
+        supperwareSettingsChangedCallback = [this](bool isRightEarChirality) {
+            std::string chir_cmd;
+            if (isRightEarChirality) {
+                chir_cmd = "1";
+            } else {
+                chir_cmd = "0";
+            }
+            orientationClient->command_setAdditionalDeviceSettings("sw_chir="+chir_cmd);
+        };
+        disconnectClickedCallback = [this]() {
+            orientationClient->command_disconnect();
+        };
+        recenterClickedCallback = [this]() {
+            orientationClient->command_recenter();
+        };
+        yprSwitchesClickedCallback = [this](int whichone) {
+            if (whichone == 0)
+                // yaw clicked
+                orientationClient->command_setTrackingYawEnabled(!orientationClient->getTrackingYawEnabled());
+            if (whichone == 1)
+                // pitch clicked
+                orientationClient->command_setTrackingPitchEnabled(!orientationClient->getTrackingPitchEnabled());
+            if (whichone == 2)
+                // roll clicked
+                orientationClient->command_setTrackingRollEnabled(!orientationClient->getTrackingRollEnabled());
+            if (whichone == 3)
+                // yaw invert clicked
+                orientationClient->command_setTrackingYawInverted(!orientationClient->getTrackingYawInverted());
+            if (whichone == 4)
+                // pitch invert clicked
+                orientationClient->command_setTrackingPitchInverted(!orientationClient->getTrackingPitchInverted());
+            if (whichone == 5)
+                // roll invert clicked
+                orientationClient->command_setTrackingRollInverted(!orientationClient->getTrackingRollInverted());
+        };
+    }
 };
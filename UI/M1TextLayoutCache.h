@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "MurkaView.h"
+
+using namespace murka;
+
+// Font and text measurement cache for M1Label and the dropdown widgets.
+// Each (font name, size) is loaded from the binary data once and kept as its own FontObject, which
+// the widgets draw with directly instead of through Murka's current font, so a window switching
+// sizes several times per frame never reloads. Bounding boxes are keyed by font and string, so a
+// label is only re-measured when one of them changes. FontObjects belong to a Murka instance and every editor draws its Murka on its own
+// render thread, so a cache is owned by one window (see M1OrientationClientWindow) and handed to
+// the widgets it draws; it is only used from that Murka's drawing thread and dies with it.
+class M1TextLayoutCache {
+public:
+    // Widgets drawn without a cache (`cache` is null) load the font and measure uncached
+    static FontObject* getFont(M1TextLayoutCache* cache, Murka& m, const char* fontName, const char* data, int dataSize, int size) {
+        if (cache != nullptr) {
+            return cache->getFont(m, fontName, data, dataSize, size);
+        }
+        m.setFontFromRawData(fontName, data, dataSize, size);
+        return m.getCurrentFont();
+    }
+
+    static juceFontStash::Rectangle measure(M1TextLayoutCache* cache, FontObject* font, const std::string& text) {
+        if (cache != nullptr) {
+            return cache->measure(font, text);
+        }
+        return font->getStringBoundingBox(text, 0, 0);
+    }
+
+    // The font at `size`, loaded on first use only. It is not made current, draw with the returned font
+    FontObject* getFont(Murka& m, const char* fontName, const char* data, int dataSize, int size) {
+        FontObject*& font = fonts[combine(hashString(fontName), (std::uint64_t)size)];
+        if (font == nullptr) {
+            m.setFontFromRawData(fontName, data, dataSize, size);
+            font = m.getCurrentFont();
+        }
+        return font;
+    }
+
+    // Left edge of text `textWidth` wide aligned in a box `width` wide starting at 0
+    static float alignText(TextAlignment alignment, float width, float textWidth) {
+        if (alignment == TEXT_CENTER) {
+            return width / 2 - textWidth / 2;
+        }
+        if (alignment == TEXT_RIGHT) {
+            return width - textWidth;
+        }
+        return 0;
+    }
+
+    // Bounding box of `text` drawn at 0, 0 with `font`
+    juceFontStash::Rectangle measure(FontObject* font, const std::string& text) {
+        std::uint64_t key = combine((std::uint64_t)(std::uintptr_t)font, hashString(text));
+        auto it = measurements.find(key);
+        if (it != measurements.end() && it->second.font == font && it->second.text == text) {
+            return it->second.box;
+        }
+
+        if (measurements.size() >= MAX_MEASUREMENTS) {
+            // Long-running editors with changing device lists, start over rather than grow
+            measurements.clear();
+        }
+        Measurement& measurement = measurements[key];
+        measurement.font = font;
+        measurement.text = text;
+        measurement.box = font->getStringBoundingBox(text, 0, 0);
+        return measurement.box;
+    }
+
+    // Call when fonts are reloaded (e.g. on a screen scale change)
+    void clear() {
+        fonts.clear();
+        measurements.clear();
+    }
+
+private:
+    static constexpr std::size_t MAX_MEASUREMENTS = 1024;
+
+    struct Measurement {
+        FontObject* font = nullptr;
+        std::string text;
+        juceFontStash::Rectangle box;
+    };
+
+    std::unordered_map<std::uint64_t, FontObject*> fonts;
+    std::unordered_map<std::uint64_t, Measurement> measurements;
+
+    static std::uint64_t hashString(std::string_view text) {
+        return std::hash<std::string_view>()(text);
+    }
+
+    static std::uint64_t combine(std::uint64_t a, std::uint64_t b) {
+        return a ^ (b + 0x9e3779b97f4a7c15ull + (a << 6) + (a >> 2));
+    }
+};
@@ -0,0 +1,250 @@
+// Micro-benchmarks for the client's hot paths: /ping parsing, device info handling,
+// lock-free orientation reads, the euler/quaternion conversions, batch direction rotation, the transform
+// pipeline and the YPR readout text.
+//
+// Run with `--benchmark_format=json` (or `--benchmark_out=results.json`) to track results per commit.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "M1OrientationBatchRotation.h"
+#include "M1OrientationProtocol.h"
+#include "M1OrientationSnapshot.h"
+#include "M1OrientationTrace.h"
+#include "M1OrientationTransform.h"
+#include "UI/M1FixedPointText.h"
+
+#include "libs/json/single_include/nlohmann/json.hpp"
+
+static std::string makePingBody(int deviceCount, bool quaternion) {
+    nlohmann::json j;
+    j["devices"] = nlohmann::json::array();
+    for (int i = 0; i < deviceCount; i++) {
+        j["devices"].push_back({ "Mach1 Tracker " + std::to_string(i), (int)M1OrientationManagerDeviceTypeBLE, "F3A1C2D4-0000-4E5B-9A2B-" + std::to_string(100000000000 + i), true, -40 - i % 50 });
+    }
+    j["currentDeviceIdx"] = deviceCount > 0 ? 0 : -1;
+    if (quaternion) {
+        j["orientation"] = { 0.9238795f, 0.0f, 0.3826834f, 0.0f };
+    } else {
+        j["orientation"] = { 0.25f, -0.1f, 0.05f };
+    }
+    j["trackingEnabled"] = { true, true, true };
+    j["trackingInverted"] = { false, false, false };
+    return j.dump();
+}
+
+static void BM_ParsePingResponse(benchmark::State& state) {
+    std::string body = makePingBody((int)state.range(0), state.range(1) != 0);
+    M1OrientationPingResponse response;
+    for (auto _ : state) {
+        bool parsed = response.parse(body);
+        benchmark::DoNotOptimize(parsed);
+        benchmark::DoNotOptimize(response.devices.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)body.size());
+}
+BENCHMARK(BM_ParsePingResponse)->ArgNames({ "devices", "quat" })->ArgsProduct({ { 0, 1, 8, 64, 256 }, { 0, 1 } });
+
+static M1OrientationDeviceInfo makeDevice(int i) {
+    return M1OrientationDeviceInfo("Mach1 Tracker " + std::to_string(i), M1OrientationManagerDeviceTypeBLE, "F3A1C2D4-0000-4E5B-9A2B-" + std::to_string(100000000000 + i), -40, 80);
+}
+
+static void BM_DeviceInfoConstruct(benchmark::State& state) {
+    std::string name = "Mach1 Tracker 42";
+    std::string address = "F3A1C2D4-0000-4E5B-9A2B-100000000042";
+    for (auto _ : state) {
+        M1OrientationDeviceInfo device(name, M1OrientationManagerDeviceTypeBLE, address, -40, 80);
+        benchmark::DoNotOptimize(device);
+    }
+}
+BENCHMARK(BM_DeviceInfoConstruct);
+
+static void BM_DeviceInfoCopy(benchmark::State& state) {
+    M1OrientationDeviceInfo device = makeDevice(42);
+    for (auto _ : state) {
+        M1OrientationDeviceInfo copy = device;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_DeviceInfoCopy);
+
+static void BM_DeviceInfoHash(benchmark::State& state) {
+    M1OrientationDeviceInfo device = makeDevice(42);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(M1OrientationDeviceInfo::Hash()(device));
+    }
+}
+BENCHMARK(BM_DeviceInfoHash);
+
+static void BM_DeviceInfoFind(benchmark::State& state) {
+    std::vector<M1OrientationDeviceInfo> devices;
+    for (int i = 0; i < state.range(0); i++) {
+        devices.push_back(makeDevice(i));
+    }
+    M1OrientationDeviceInfo query = makeDevice((int)state.range(0) - 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(std::find(devices.begin(), devices.end(), query));
+    }
+}
+BENCHMARK(BM_DeviceInfoFind)->Arg(8)->Arg(64)->Arg(256);
+
+// Same path as M1OrientationClient::getOrientation(): thread 0 keeps publishing like the
+// polling thread while the other threads read
+static M1OrientationSnapshot<Mach1::Orientation> sharedOrientation;
+
+static void BM_GetOrientationContended(benchmark::State& state) {
+    Mach1::Orientation orientation;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && state.threads() > 1) {
+            sharedOrientation.publish(orientation);
+        } else {
+            benchmark::DoNotOptimize(sharedOrientation.read());
+        }
+    }
+}
+BENCHMARK(BM_GetOrientationContended)->ThreadRange(1, 8)->UseRealTime();
+
+// Same path as M1OrientationClient::getDevices(): copy of the device list under the client mutex
+static std::mutex sharedDevicesMutex;
+static std::vector<M1OrientationDeviceInfo> sharedDevices;
+
+static void BM_GetDevicesContended(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        std::lock_guard<std::mutex> lock(sharedDevicesMutex);
+        sharedDevices.clear();
+        for (int i = 0; i < state.range(0); i++) {
+            sharedDevices.push_back(makeDevice(i));
+        }
+    }
+    for (auto _ : state) {
+        sharedDevicesMutex.lock();
+        std::vector<M1OrientationDeviceInfo> devices = sharedDevices;
+        sharedDevicesMutex.unlock();
+        benchmark::DoNotOptimize(devices.data());
+    }
+}
+BENCHMARK(BM_GetDevicesContended)->Arg(8)->Arg(64)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_EulerToQuaternion(benchmark::State& state) {
+    Mach1::Orientation orientation;
+    float yaw = 0;
+    for (auto _ : state) {
+        orientation.SetRotation(Mach1::Float3(yaw, 0.1f, -0.2f));
+        benchmark::DoNotOptimize(orientation.GetGlobalRotationAsQuaternion());
+        yaw += 0.001f;
+    }
+}
+BENCHMARK(BM_EulerToQuaternion);
+
+static void BM_QuaternionToEulerDegrees(benchmark::State& state) {
+    Mach1::Orientation orientation;
+    orientation.SetRotation(Mach1::Quaternion(0.9238795f, 0.0f, 0.3826834f, 0.0f));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(orientation.GetGlobalRotationAsEulerDegrees());
+    }
+}
+BENCHMARK(BM_QuaternionToEulerDegrees);
+
+// Rotating a block of source directions, per-vector scalar code vs the vectorized kernel
+static void makeDirections(std::size_t count, std::vector<float>& x, std::vector<float>& y, std::vector<float>& z) {
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        x[i] = std::cos(i * 0.1f);
+        y[i] = std::sin(i * 0.1f);
+        z[i] = 0.5f;
+    }
+}
+
+static void BM_RotateDirectionsScalar(benchmark::State& state) {
+    std::vector<float> x, y, z;
+    makeDirections((std::size_t)state.range(0), x, y, z);
+    std::vector<float> outX(x.size()), outY(x.size()), outZ(x.size());
+    M1OrientationBatchRotation::Matrix matrix = M1OrientationBatchRotation::makeMatrix(Mach1::Quaternion(0.9238795f, 0.0f, 0.3826834f, 0.0f));
+    for (auto _ : state) {
+        M1OrientationBatchRotation::rotateScalar(matrix, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), x.size());
+        benchmark::DoNotOptimize(outX.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RotateDirectionsScalar)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_RotateDirectionsBatch(benchmark::State& state) {
+    std::vector<float> x, y, z;
+    makeDirections((std::size_t)state.range(0), x, y, z);
+    std::vector<float> outX(x.size()), outY(x.size()), outZ(x.size());
+    Mach1::Quaternion rotation(0.9238795f, 0.0f, 0.3826834f, 0.0f);
+    state.SetLabel(M1OrientationBatchRotation::getInstructionSet());
+    for (auto _ : state) {
+        M1OrientationBatchRotation::rotate(rotation, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), x.size());
+        benchmark::DoNotOptimize(outX.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RotateDirectionsBatch)->Arg(16)->Arg(256)->Arg(4096);
+
+// Per-sample cost of the client transform, composed pipeline called through the client's interface
+static void BM_TransformPipeline(benchmark::State& state) {
+    std::unique_ptr<M1OrientationTransform> transform = std::make_unique<M1OrientationPipeline<M1OrientationRecenterStage, M1OrientationAxisStage, M1OrientationSmoothingStage, M1OrientationConventionStage>>();
+    Mach1::Quaternion rotation(0.9238795f, 0.0f, 0.3826834f, 0.0f);
+    int64_t timestampMicros = 0;
+    for (auto _ : state) {
+        timestampMicros += 10000;
+        benchmark::DoNotOptimize(transform->process(rotation, timestampMicros));
+    }
+}
+BENCHMARK(BM_TransformPipeline);
+
+// Per-sample cost of recording to a trace file
+static void BM_TraceWriteRecord(benchmark::State& state) {
+    std::string path = (std::filesystem::temp_directory_path() / "m1_orientation_benchmark.m1trace").string();
+    M1OrientationTraceWriter writer;
+    writer.open(path);
+    M1OrientationTraceRecord record;
+    for (auto _ : state) {
+        record.sequence++;
+        record.timestampMicros += 30000;
+        writer.write(record);
+    }
+    writer.close();
+    std::remove(path.c_str());
+    state.SetBytesProcessed(state.iterations() * (int64_t)sizeof(M1OrientationTraceRecord));
+}
+BENCHMARK(BM_TraceWriteRecord);
+
+// YPR readout text, as the window used to build it every frame vs M1FixedPointText
+static void BM_FormatYprStringstream(benchmark::State& state) {
+    float yaw = 0;
+    for (auto _ : state) {
+        std::stringstream tmp;
+        tmp << std::fixed << std::setprecision(2) << yaw + 0.0;
+        benchmark::DoNotOptimize(tmp.str());
+        yaw += 0.001f;
+    }
+}
+BENCHMARK(BM_FormatYprStringstream);
+
+static void BM_FormatYprFixedPoint(benchmark::State& state) {
+    M1FixedPointText<2> text;
+    float yaw = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(text.set(yaw));
+        yaw += 0.001f;
+    }
+}
+BENCHMARK(BM_FormatYprFixedPoint);
+
+BENCHMARK_MAIN();
@@ -1,5 +1,13 @@
 #include "m1_orientation_client.h"
 
+#include "M1OrientationStringTable.cpp"
 #include "M1OrientationTypes.cpp"
 #include "M1OrientationSettings.cpp"
+#include "M1OrientationProtocol.cpp"
+#include "M1OrientationFusion.cpp"
+#include "M1OrientationBatchRotation.cpp"
+#include "M1OrientationStats.cpp"
+#include "M1OrientationTrace.cpp"
+#include "M1OrientationTracing.cpp"
+#include "M1OrientationRealtimeAudit.cpp"
 #include "M1OrientationClient.cpp"
@@ -24,11 +24,50 @@
 
 #pragma once
 
+/** Config: M1_ORIENTATION_TRACING
+    Enables per-stage trace spans (see M1OrientationTracing.h), exportable as Chrome trace JSON.
+    Compiled out when disabled.
+*/
+#ifndef M1_ORIENTATION_TRACING
+ #define M1_ORIENTATION_TRACING 0
+#endif
+
+/** Config: M1_ORIENTATION_RT_AUDIT
+    Counts or traps heap allocations, locks and blocking system calls made by client APIs on threads
+    marked as real-time (see M1OrientationRealtimeAudit.h). Replaces global operator new/delete, debug and test builds only.
+*/
+#ifndef M1_ORIENTATION_RT_AUDIT
+ #define M1_ORIENTATION_RT_AUDIT 0
+#endif
+
+/** Config: M1_ORIENTATION_COMPACT_DEVICE_INFO
+    Packs M1OrientationDeviceInfo into a cache line by moving signalStrength, batteryPercentage, error,
+    osc_port and osc_msg_addr_pttrn behind their accessors. Disabled by default, the fields stay public
+    for code reading them directly and device infos then take about two cache lines; the accessors
+    work in both layouts. Enable it once a project only uses the accessors.
+*/
+#ifndef M1_ORIENTATION_COMPACT_DEVICE_INFO
+ #define M1_ORIENTATION_COMPACT_DEVICE_INFO 0
+#endif
+
 // TODO: fix this definition
 // #if defined(WIN32) && !defined(WIN32_LEAN_AND_MEAN) 
 // #error need to define WIN32_LEAN_AND_MEAN in project settings
 // #endif
 
+#include "M1OrientationStringTable.h"
 #include "M1OrientationTypes.h"
 #include "M1OrientationSettings.h"
+#include "M1OrientationProtocol.h"
+#include "M1OrientationSnapshot.h"
+#include "M1OrientationFusion.h"
+#include "M1OrientationBatchRotation.h"
+#include "M1OrientationTransform.h"
+#include "M1OrientationConventionAdapter.h"
+#include "M1OrientationHistory.h"
+#include "M1OrientationClockSync.h"
+#include "M1OrientationStats.h"
+#include "M1OrientationTrace.h"
+#include "M1OrientationTracing.h"
+#include "M1OrientationRealtimeAudit.h"
 #include "M1OrientationClient.h"
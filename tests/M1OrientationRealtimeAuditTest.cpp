@@ -0,0 +1,133 @@
+// Checks the real-time safe subset of the client API listed in M1OrientationRealtimeAudit.h: built
+// with M1_ORIENTATION_RT_AUDIT=1 and M1_ORIENTATION_TRACING=1, it replays a generated trace through
+// a real M1OrientationClient and calls every listed API from a thread marked as real-time, failing
+// on any allocation, client mutex lock or blocking system call made inside them.
+
+#include <JuceHeader.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "libs/json/single_include/nlohmann/json.hpp"
+
+#include "M1OrientationClient.h"
+
+#if !M1_ORIENTATION_RT_AUDIT || !M1_ORIENTATION_TRACING
+#error "build with M1_ORIENTATION_RT_AUDIT=1 and M1_ORIENTATION_TRACING=1"
+#endif
+
+static bool writeYawSweepTrace(const std::string& path) {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    M1OrientationTraceWriter writer;
+    if (!writer.open(path)) {
+        return false;
+    }
+    for (int i = 0; i < 400; i++) {
+        float halfAngle = 0.5f * (float)i * 0.01f;
+        M1OrientationTraceRecord record;
+        record.timestampMicros = (int64_t)i * 5000;
+        record.sequence = (uint32_t)i + 1;
+        record.flags = M1OrientationTraceRecord::MainOrientation | M1OrientationTraceRecord::TrackingYawEnabled
+            | M1OrientationTraceRecord::TrackingPitchEnabled | M1OrientationTraceRecord::TrackingRollEnabled;
+        record.quaternion[0] = std::cos(halfAngle);
+        record.quaternion[1] = 0;
+        record.quaternion[2] = std::sin(halfAngle);
+        record.quaternion[3] = 0;
+        writer.write(record);
+    }
+    writer.close();
+    return true;
+}
+
+// Every API of the real-time safe subset, once
+static void callRealtimeApis(M1OrientationClient& client, M1OrientationHistorySample* history, std::size_t historySize, float* directions) {
+    Mach1::Orientation orientation = client.getOrientation();
+    orientation = client.getRawOrientation();
+    client.getOrientationHistory(history, historySize);
+    client.getOrientationAt(M1OrientationStats::nowMicros() - 10000, orientation);
+    client.rotateDirections(directions, directions + 8, directions + 16, directions + 24, directions + 32, directions + 40, 8);
+    client.getDeviceOrientation(1, orientation);
+    orientation = client.getFusedOrientation();
+    client.isFusionActive();
+    client.getTrackingYawEnabled();
+    client.getTrackingPitchEnabled();
+    client.getTrackingRollEnabled();
+    client.getTrackingYawInverted();
+    client.getTrackingPitchInverted();
+    client.getTrackingRollInverted();
+    client.getStateGeneration();
+    client.getOrientationVersion();
+    client.getDeviceStreamsFrame();
+    client.hasReceivedFirstSample();
+    client.isConnectedToServer();
+    client.isConnectedToDevice();
+    client.getCurrentDeviceType();
+    client.isRecording();
+    client.isReplaying();
+}
+
+int main() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::filesystem::path settingsFile = directory / "m1_orientation_realtime_audit_test.json";
+    std::filesystem::path traceFile = directory / "m1_orientation_realtime_audit_test.m1ot";
+    // No server listens on port 1, the replayed trace stands in for it
+    std::ofstream(settingsFile) << nlohmann::json({ { "serverPort", 1 }, { "helperPort", 0 } }).dump();
+    if (!writeYawSweepTrace(traceFile.string())) {
+        std::fprintf(stderr, "Could not write %s\n", traceFile.string().c_str());
+        return 1;
+    }
+
+    // Spans recorded by the polling thread must not leak onto the real-time thread
+    M1OrientationTracing::setEnabled(true);
+
+    M1OrientationClient client;
+    client.setSettingsFilePath(settingsFile.string());
+    if (!client.init(1, 0) || !client.startReplay(traceFile.string(), 1.0, true)) {
+        std::fprintf(stderr, "Client failed to start\n");
+        return 1;
+    }
+    for (int i = 0; i < 200 && client.getOrientationVersion() < 20; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (client.getOrientationVersion() == 0) {
+        std::fprintf(stderr, "The replay published no orientation\n");
+        return 1;
+    }
+
+    // Reads run while the replay keeps publishing, like an audio callback next to the polling thread
+    M1OrientationHistorySample history[64];
+    float directions[48] = {};
+    M1OrientationRealtimeAudit::reset();
+    std::thread realtimeThread([&]() {
+        M1OrientationRealtimeAudit::ScopedRealtimeThread realtime;
+        for (int block = 0; block < 2000; block++) {
+            callRealtimeApis(client, history, 64, directions);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    });
+    realtimeThread.join();
+    M1OrientationRealtimeAudit::Counts counts = M1OrientationRealtimeAudit::getCounts();
+
+    client.stopReplay();
+    client.close();
+    std::error_code error;
+    std::filesystem::remove(settingsFile, error);
+    std::filesystem::remove(traceFile, error);
+
+    if (counts.total() != 0) {
+        static const char* violationNames[] = { "allocation", "lock", "syscall" };
+        std::fprintf(stderr, "Real-time violations: %llu allocations, %llu locks, %llu syscalls, last a %s in %s()\n",
+                     (unsigned long long)counts.allocations, (unsigned long long)counts.locks, (unsigned long long)counts.syscalls,
+                     counts.lastViolation < M1OrientationRealtimeAudit::ViolationCount ? violationNames[counts.lastViolation] : "violation",
+                     counts.lastApi != nullptr ? counts.lastApi : "?");
+        return 1;
+    }
+    std::printf("No real-time violations in the real-time safe APIs\n");
+    return 0;
+}
@@ -0,0 +1,203 @@
+// Load driver for the orientation server (real or tools/M1OrientationMockServer). Runs many real
+// M1OrientationClient instances in one process, each with its own polling thread and a reader
+// thread standing in for an audio callback, and reports the clients' round trip time, sample age
+// at read (needs a server reporting `timestampMicros`), parse time, update rate and CPU use. Every
+// client starts tracking the listed device at `--device` before the measurement starts.
+//
+//   m1_orientation_load_driver --port 6345 --clients 64 --seconds 30 --read-interval-ms 1
+//
+// Results are printed as one JSON object so runs can be compared across commits. Counts are summed
+// over the clients, latency percentiles are those of the worst client. The run fails when the
+// clients receive no samples, since every number then measures an idle server.
+
+#include <JuceHeader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "libs/json/single_include/nlohmann/json.hpp"
+
+#include "M1OrientationClient.h"
+
+struct LoadDriverSettings {
+    int port = 0;
+    int clients = 16;
+    double seconds = 10;
+    int readIntervalMillis = 1;
+    int device = 0; // index in the server's device list
+};
+
+// Waits for the server's device list and starts tracking the chosen device, false on timeout
+static bool startTracking(M1OrientationClient& client, int device, int timeoutMillis) {
+    for (int waited = 0; waited < timeoutMillis; waited += 10) {
+        std::vector<M1OrientationDeviceInfo> devices = client.getDevices();
+        if (device < (int)devices.size()) {
+            client.command_startTrackingUsingDevice(devices[device]);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+static double getProcessCpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+}
+
+static void accumulate(M1OrientationLatencyHistogram::Summary& total, const M1OrientationLatencyHistogram::Summary& client) {
+    if (client.count == 0) {
+        return;
+    }
+    total.meanMicros = (total.meanMicros * total.count + client.meanMicros * client.count) / (total.count + client.count);
+    total.minMicros = total.count == 0 ? client.minMicros : std::min(total.minMicros, client.minMicros);
+    total.count += client.count;
+    total.maxMicros = std::max(total.maxMicros, client.maxMicros);
+    total.p50Micros = std::max(total.p50Micros, client.p50Micros);
+    total.p90Micros = std::max(total.p90Micros, client.p90Micros);
+    total.p99Micros = std::max(total.p99Micros, client.p99Micros);
+    total.p999Micros = std::max(total.p999Micros, client.p999Micros);
+}
+
+static nlohmann::json summaryToJson(const M1OrientationLatencyHistogram::Summary& summary) {
+    return {
+        { "count", summary.count },
+        { "min_us", summary.minMicros },
+        { "mean_us", summary.meanMicros },
+        { "p50_us", summary.p50Micros },
+        { "p90_us", summary.p90Micros },
+        { "p99_us", summary.p99Micros },
+        { "p999_us", summary.p999Micros },
+        { "max_us", summary.maxMicros },
+    };
+}
+
+int main(int argc, char* argv[]) {
+    LoadDriverSettings settings;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--port") settings.port = std::atoi(value.c_str());
+        else if (arg == "--clients") settings.clients = std::atoi(value.c_str());
+        else if (arg == "--seconds") settings.seconds = std::atof(value.c_str());
+        else if (arg == "--read-interval-ms") settings.readIntervalMillis = std::atoi(value.c_str());
+        else if (arg == "--device") settings.device = std::atoi(value.c_str());
+        else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (settings.port == 0 || settings.clients <= 0 || settings.device < 0) {
+        std::cerr << "Usage: m1_orientation_load_driver --port <serverPort> [--clients n] [--seconds s] [--read-interval-ms ms] [--device index]" << std::endl;
+        return 1;
+    }
+
+    // The clients read their ports from a settings.json, point them at the server under test
+    std::filesystem::path settingsFile = std::filesystem::temp_directory_path() / ("m1_orientation_load_driver_" + std::to_string(settings.port) + ".json");
+    std::ofstream(settingsFile) << nlohmann::json({ { "serverPort", settings.port }, { "helperPort", 0 } }).dump();
+
+    std::vector<std::unique_ptr<M1OrientationClient>> clients;
+    for (int c = 0; c < settings.clients; c++) {
+        auto client = std::make_unique<M1OrientationClient>();
+        client->setSettingsFilePath(settingsFile.string());
+        client->setSampleAgeAtReadEnabled(true);
+        if (!client->init(settings.port, 0)) {
+            std::cerr << "Client " << c << " failed to start" << std::endl;
+            return 1;
+        }
+        clients.push_back(std::move(client));
+    }
+    for (int c = 0; c < settings.clients; c++) {
+        if (!startTracking(*clients[c], settings.device, 5000)) {
+            std::cerr << "Client " << c << " saw no device " << settings.device << " listed by the server" << std::endl;
+            return 1;
+        }
+    }
+
+    double cpuStart = getProcessCpuSeconds();
+    int64_t wallStart = M1OrientationStats::nowMicros();
+
+    // One reader per client, reading the orientation the way a plugin's audio callback does
+    std::atomic<bool> running { true };
+    std::vector<std::thread> readers;
+    for (auto& client : clients) {
+        readers.emplace_back([&running, &settings, client = client.get()]() {
+            float x[8] = { 1, 0, 0, 0, 1, 0, 0, 0 }, y[8] = {}, z[8] = {};
+            while (running) {
+                client->rotateDirections(x, y, z, x, y, z, 8);
+                std::this_thread::sleep_for(std::chrono::milliseconds(settings.readIntervalMillis));
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(settings.seconds * 1000000)));
+    running = false;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    double wallSeconds = (M1OrientationStats::nowMicros() - wallStart) / 1000000.0;
+    double cpuSeconds = getProcessCpuSeconds() - cpuStart;
+
+    M1OrientationClientStats results;
+    int connectedClients = 0;
+    for (auto& client : clients) {
+        M1OrientationClientStats clientStats = client->getStats();
+        accumulate(results.pingRoundTrip, clientStats.pingRoundTrip);
+        accumulate(results.parseDuration, clientStats.parseDuration);
+        accumulate(results.sampleAgeAtRead, clientStats.sampleAgeAtRead);
+        results.samplesReceived += clientStats.samplesReceived;
+        results.samplesRejected += clientStats.samplesRejected;
+        results.pingsSucceeded += clientStats.pingsSucceeded;
+        results.pingsFailed += clientStats.pingsFailed;
+        connectedClients += client->isConnectedToServer() ? 1 : 0;
+    }
+
+    // Destroying a client waits for its polling thread, doing it in parallel keeps shutdown short
+    std::vector<std::thread> closers;
+    for (auto& client : clients) {
+        closers.emplace_back([client = std::move(client)]() mutable {
+            client.reset();
+        });
+    }
+    for (auto& closer : closers) {
+        closer.join();
+    }
+    std::error_code error;
+    std::filesystem::remove(settingsFile, error);
+
+    nlohmann::json report = {
+        { "clients", settings.clients },
+        { "connected_clients", connectedClients },
+        { "read_interval_ms", settings.readIntervalMillis },
+        { "wall_seconds", wallSeconds },
+        { "cpu_seconds", cpuSeconds },
+        { "cpu_percent_of_one_core", 100.0 * cpuSeconds / wallSeconds },
+        { "pings_succeeded", results.pingsSucceeded },
+        { "pings_failed", results.pingsFailed },
+        { "samples_received", results.samplesReceived },
+        { "samples_rejected", results.samplesRejected },
+        { "new_samples_per_second", results.samplesReceived / wallSeconds },
+        { "ping_round_trip", summaryToJson(results.pingRoundTrip) },
+        { "parse_duration", summaryToJson(results.parseDuration) },
+        { "sample_age", summaryToJson(results.sampleAgeAtRead) },
+    };
+    std::cout << report.dump(2) << std::endl;
+    if (results.samplesReceived == 0) {
+        std::cerr << "No samples received, the server is not streaming the tracked device" << std::endl;
+        return 1;
+    }
+    return 0;
+}
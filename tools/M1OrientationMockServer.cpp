@@ -0,0 +1,312 @@
+// Stand-in for the Mach1 orientation server, for exercising M1OrientationClient without hardware.
+// Serves the same HTTP endpoints, generates synthetic head motion (or replays a recorded trace)
+// at a fixed rate and can inject latency, jitter and dropped responses.
+//
+//   m1_orientation_mock_server --port 6345 --rate 100 --devices 4 --latency-ms 2 --jitter-ms 1 --drop 0.01
+//   m1_orientation_mock_server --port 6345 --trace head_motion.csv --speed 2
+//
+// Trace files are CSV lines of `seconds,yaw,pitch,roll` (normalized -1..1) or `seconds,w,x,y,z`.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "libs/httplib/httplib.h"
+#include "libs/json/single_include/nlohmann/json.hpp"
+
+#include "M1OrientationTypes.h"
+
+struct MockServerSettings {
+    int port = 0;
+    double rateHz = 100;
+    int deviceCount = 3;
+    std::string tracePath;
+    double speed = 1.0;
+    double latencyMillis = 0;
+    double jitterMillis = 0;
+    double dropProbability = 0;
+};
+
+struct TraceFrame {
+    double seconds = 0;
+    std::vector<float> values; // 3 normalized euler or 4 quaternion values
+};
+
+static int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool loadTrace(const std::string& path, std::vector<TraceFrame>& frames) {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::stringstream stream(line);
+        std::string cell;
+        TraceFrame frame;
+        bool first = true;
+        while (std::getline(stream, cell, ',')) {
+            if (first) {
+                frame.seconds = std::atof(cell.c_str());
+                first = false;
+            } else {
+                frame.values.push_back((float)std::atof(cell.c_str()));
+            }
+        }
+        if (frame.values.size() == 3 || frame.values.size() == 4) {
+            frames.push_back(frame);
+        }
+    }
+    return !frames.empty();
+}
+
+class MockOrientationServer
+{
+public:
+    MockOrientationServer(MockServerSettings settings_) : settings(settings_), random(std::random_device()()) {
+        for (int i = 0; i < settings.deviceCount; i++) {
+            devices.push_back(M1OrientationDeviceInfo("Mock Tracker " + std::to_string(i), M1OrientationManagerDeviceTypeBLE, "MOCK-" + std::to_string(i), -40 - i));
+        }
+    }
+
+    bool start() {
+        if (!settings.tracePath.empty() && !loadTrace(settings.tracePath, trace)) {
+            std::cerr << "Could not read trace " << settings.tracePath << std::endl;
+            return false;
+        }
+
+        running = true;
+        generator = std::thread([this]() { generate(); });
+
+        server.Get("/ping", [this](const httplib::Request& req, httplib::Response& res) { handlePing(req, res); });
+        server.Post("/startTrackingUsingDevice", [this](const httplib::Request& req, httplib::Response&) {
+            auto j = nlohmann::json::parse(req.body, nullptr, false);
+            std::lock_guard<std::mutex> lock(mutex);
+            currentDeviceIdx = -1;
+            for (int i = 0; i < (int)devices.size(); i++) {
+                if (j.is_array() && j.size() >= 3 && devices[i].getDeviceName() == j[0] && devices[i].getDeviceAddress() == j[2]) {
+                    currentDeviceIdx = i;
+                }
+            }
+        });
+        server.Post("/disconnect", [this](const httplib::Request&, httplib::Response&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentDeviceIdx = -1;
+        });
+        server.Post("/recenter", [this](const httplib::Request&, httplib::Response&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (currentValues.size() == 3) {
+                yawOffset = -currentValues[0];
+            }
+        });
+        server.Post("/devicesrefresh", [](const httplib::Request&, httplib::Response&) {});
+        server.Post("/setDeviceSettings", [](const httplib::Request& req, httplib::Response&) {
+            std::cout << "setDeviceSettings " << req.body << std::endl;
+        });
+        server.Post("/subscribeDevices", [this](const httplib::Request& req, httplib::Response&) {
+            auto j = nlohmann::json::parse(req.body, nullptr, false);
+            std::lock_guard<std::mutex> lock(mutex);
+            subscribedDeviceIdxs.clear();
+            for (int i = 0; i < (int)devices.size(); i++) {
+                for (auto& entry : j) {
+                    if (entry.is_array() && entry.size() >= 3 && devices[i].getDeviceName() == entry[0] && devices[i].getDeviceAddress() == entry[2]) {
+                        subscribedDeviceIdxs.push_back(i);
+                    }
+                }
+            }
+        });
+
+        const char* flagNames[3] = { "Yaw", "Pitch", "Roll" };
+        for (int i = 0; i < 3; i++) {
+            server.Post(std::string("/setTracking") + flagNames[i] + "Enabled", [this, i](const httplib::Request& req, httplib::Response&) {
+                auto j = nlohmann::json::parse(req.body, nullptr, false);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (j.is_array() && !j.empty()) trackingEnabled[i] = j[0];
+            });
+            server.Post(std::string("/setTracking") + flagNames[i] + "Inverted", [this, i](const httplib::Request& req, httplib::Response&) {
+                auto j = nlohmann::json::parse(req.body, nullptr, false);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (j.is_array() && !j.empty()) trackingInverted[i] = j[0];
+            });
+        }
+
+        std::cout << "Mock orientation server listening on " << settings.port << std::endl;
+        bool listened = server.listen("127.0.0.1", settings.port);
+        running = false;
+        generator.join();
+        return listened;
+    }
+
+private:
+    MockServerSettings settings;
+    httplib::Server server;
+    std::thread generator;
+    std::atomic<bool> running { false };
+    std::mutex mutex;
+    std::mt19937 random;
+    std::vector<TraceFrame> trace;
+
+    // guarded by `mutex`
+    std::vector<M1OrientationDeviceInfo> devices;
+    std::vector<int> subscribedDeviceIdxs;
+    int currentDeviceIdx = -1;
+    bool trackingEnabled[3] = { true, true, true };
+    bool trackingInverted[3] = { false, false, false };
+    std::vector<float> currentValues = { 0, 0, 0 };
+    int64_t currentTimestampMicros = 0;
+    uint32_t sequence = 0;
+    float yawOffset = 0;
+
+    // Recent generated samples for clients that poll with ?since=, guarded by `mutex`
+    struct RecentSample {
+        uint32_t sequence;
+        int64_t timestampMicros;
+        std::vector<float> values;
+    };
+    static constexpr size_t MAX_RECENT_SAMPLES = 64;
+    std::deque<RecentSample> recentSamples;
+
+    void generate() {
+        auto interval = std::chrono::microseconds((int64_t)(1000000.0 / settings.rateHz));
+        auto next = std::chrono::steady_clock::now();
+        int64_t startMicros = nowMicros();
+
+        while (running) {
+            double seconds = (nowMicros() - startMicros) / 1000000.0 * settings.speed;
+            std::vector<float> values;
+            if (!trace.empty()) {
+                double loopSeconds = std::fmod(seconds, trace.back().seconds > 0 ? trace.back().seconds : 1.0);
+                size_t i = 0;
+                while (i + 1 < trace.size() && trace[i + 1].seconds <= loopSeconds) i++;
+                values = trace[i].values;
+            } else {
+                // Slow look-around with a little nodding and tilting
+                values = {
+                    (float)(0.5 * std::sin(2 * M_PI * 0.25 * seconds)),
+                    (float)(0.15 * std::sin(2 * M_PI * 0.4 * seconds)),
+                    (float)(0.08 * std::sin(2 * M_PI * 0.7 * seconds)),
+                };
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                currentValues = values;
+                currentTimestampMicros = nowMicros();
+                sequence++;
+                recentSamples.push_back({ sequence, currentTimestampMicros, values });
+                if (recentSamples.size() > MAX_RECENT_SAMPLES) {
+                    recentSamples.pop_front();
+                }
+            }
+
+            next += interval;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    // Recenter offset and tracking flags as the server applies them, caller holds `mutex`
+    std::vector<float> applyTracking(std::vector<float> values) const {
+        if (values.size() == 3) {
+            values[0] += yawOffset;
+            for (int i = 0; i < 3; i++) {
+                values[i] = trackingEnabled[i] ? (trackingInverted[i] ? -values[i] : values[i]) : 0.0f;
+            }
+        }
+        return values;
+    }
+
+    void handlePing(const httplib::Request& req, httplib::Response& res) {
+        double delayMillis = settings.latencyMillis;
+        if (settings.jitterMillis > 0) {
+            std::uniform_real_distribution<double> jitter(-settings.jitterMillis, settings.jitterMillis);
+            std::lock_guard<std::mutex> lock(mutex);
+            delayMillis += jitter(random);
+        }
+        if (delayMillis > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(delayMillis * 1000)));
+        }
+
+        nlohmann::json j;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (settings.dropProbability > 0 && std::uniform_real_distribution<double>(0, 1)(random) < settings.dropProbability) {
+                res.status = 503;
+                return;
+            }
+
+            j["devices"] = nlohmann::json::array();
+            for (auto& device : devices) {
+                j["devices"].push_back({ device.getDeviceName(), (int)device.getDeviceType(), device.getDeviceAddress(), true, std::get<int>(device.getDeviceSignalStrength()) });
+            }
+            j["currentDeviceIdx"] = currentDeviceIdx;
+
+            j["orientation"] = currentDeviceIdx >= 0 ? applyTracking(currentValues) : std::vector<float>();
+            j["timestampMicros"] = currentTimestampMicros;
+            j["sequence"] = sequence;
+            j["trackingEnabled"] = { trackingEnabled[0], trackingEnabled[1], trackingEnabled[2] };
+            j["trackingInverted"] = { trackingInverted[0], trackingInverted[1], trackingInverted[2] };
+
+            // Batching: every sample generated after the client's last one, [sequence, timestampMicros, orientation]
+            if (req.has_param("since") && currentDeviceIdx >= 0) {
+                uint32_t since = (uint32_t)std::strtoul(req.get_param_value("since").c_str(), nullptr, 10);
+                j["samples"] = nlohmann::json::array();
+                for (auto& sample : recentSamples) {
+                    if ((int32_t)(sample.sequence - since) > 0) {
+                        j["samples"].push_back({ sample.sequence, sample.timestampMicros, applyTracking(sample.values) });
+                    }
+                }
+            }
+
+            if (!subscribedDeviceIdxs.empty()) {
+                j["deviceOrientations"] = nlohmann::json::array();
+                for (int idx : subscribedDeviceIdxs) {
+                    // Every mock device follows the same motion with its own phase
+                    std::vector<float> deviceValues = currentValues;
+                    if (deviceValues.size() == 3) deviceValues[0] = std::fmod(deviceValues[0] + 0.1f * idx + 1.0f, 2.0f) - 1.0f;
+                    j["deviceOrientations"].push_back({ idx, deviceValues, currentTimestampMicros });
+                }
+            }
+        }
+        res.set_content(j.dump(), "application/json");
+    }
+};
+
+int main(int argc, char* argv[]) {
+    MockServerSettings settings;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--port") settings.port = std::atoi(value.c_str());
+        else if (arg == "--rate") settings.rateHz = std::atof(value.c_str());
+        else if (arg == "--devices") settings.deviceCount = std::atoi(value.c_str());
+        else if (arg == "--trace") settings.tracePath = value;
+        else if (arg == "--speed") settings.speed = std::atof(value.c_str());
+        else if (arg == "--latency-ms") settings.latencyMillis = std::atof(value.c_str());
+        else if (arg == "--jitter-ms") settings.jitterMillis = std::atof(value.c_str());
+        else if (arg == "--drop") settings.dropProbability = std::atof(value.c_str());
+        else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (settings.port == 0 || settings.rateHz <= 0) {
+        std::cerr << "Usage: m1_orientation_mock_server --port <serverPort from settings.json> [--rate hz] [--devices n] [--trace file.csv] [--speed x] [--latency-ms ms] [--jitter-ms ms] [--drop probability]" << std::endl;
+        return 1;
+    }
+
+    MockOrientationServer server(settings);
+    return server.start() ? 0 : 1;
+}